@@ -0,0 +1,120 @@
+#include "AB1805_RK.h"
+
+SYSTEM_THREAD(ENABLED);
+SYSTEM_MODE(SEMI_AUTOMATIC);
+
+SerialLogHandler logHandler;
+
+// This example does not use the AB1805 hardware. It compares the speed of converting between
+// RTC time registers and time_t using struct tm with mktime/gmtime, and using 
+// AB1805::registersToTime() and AB1805::timeToRegisters() directly. It also compares decoding
+// the 8 time registers one byte at a time with AB1805::decodeTimeBlock(), which decodes and 
+// validates all of them at once.
+
+// Number of conversions per test
+const int numIterations = 10000;
+
+// Start of test range (2020-01-01 00:00:00 UTC) and increment between samples
+const time_t startTime = 1577836800;
+const time_t timeIncrement = 3607;
+
+void runBenchmark();
+
+void setup() {
+    // Optional: Enable to make it easier to see debug USB serial messages at startup
+    waitFor(Serial.isConnected, 15000);
+    delay(1000);
+
+    runBenchmark();
+}
+
+void loop() {
+}
+
+void runBenchmark() {
+    uint8_t array[7];
+    struct tm tmstruct;
+    volatile time_t sink = 0;
+    int errors = 0;
+
+    // Decode: registers to time_t
+    AB1805::timeToRegisters(startTime, array);
+
+    unsigned long start = micros();
+    for(int ii = 0; ii < numIterations; ii++) {
+        AB1805::registersToTm(array, &tmstruct, true);
+        sink = mktime(&tmstruct);
+    }
+    unsigned long mktimeUs = micros() - start;
+
+    start = micros();
+    for(int ii = 0; ii < numIterations; ii++) {
+        sink = AB1805::registersToTime(array);
+    }
+    unsigned long directUs = micros() - start;
+
+    Log.info("decode %d: mktime %lu us, registersToTime %lu us", numIterations, mktimeUs, directUs);
+
+    // Encode: time_t to registers
+    start = micros();
+    for(int ii = 0; ii < numIterations; ii++) {
+        time_t t = startTime + ii * timeIncrement;
+        AB1805::tmToRegisters(gmtime(&t), array, true);
+    }
+    unsigned long gmtimeUs = micros() - start;
+
+    start = micros();
+    for(int ii = 0; ii < numIterations; ii++) {
+        AB1805::timeToRegisters(startTime + ii * timeIncrement, array);
+    }
+    directUs = micros() - start;
+
+    Log.info("encode %d: gmtime %lu us, timeToRegisters %lu us", numIterations, gmtimeUs, directUs);
+
+    // Make sure both methods produce the same results
+    for(int ii = 0; ii < numIterations; ii++) {
+        time_t t = startTime + ii * timeIncrement;
+        uint8_t array2[7];
+
+        AB1805::timeToRegisters(t, array);
+        AB1805::tmToRegisters(gmtime(&t), array2, true);
+
+        if (memcmp(array, array2, sizeof(array)) != 0 || AB1805::registersToTime(array) != t) {
+            errors++;
+        }
+    }
+    Log.info("verified %d conversions, %d errors", numIterations, errors);
+
+    // Block decode: 8 BCD time registers to binary values
+    uint8_t block[8];
+    uint8_t values[8];
+    volatile int valid = 0;
+
+    block[0] = 0x42; // hundredths
+    AB1805::timeToRegisters(startTime, &block[1]);
+
+    start = micros();
+    for(int ii = 0; ii < numIterations; ii++) {
+        for(size_t jj = 0; jj < sizeof(block); jj++) {
+            values[jj] = (uint8_t)AB1805::bcdToValue(block[jj]);
+        }
+        valid = values[0];
+    }
+    unsigned long byteUs = micros() - start;
+
+    start = micros();
+    for(int ii = 0; ii < numIterations; ii++) {
+        valid = AB1805::decodeTimeBlock(block, values);
+    }
+    unsigned long blockUs = micros() - start;
+
+    Log.info("block decode %d: bcdToValue %lu us, decodeTimeBlock %lu us (including validation)", numIterations, byteUs, blockUs);
+
+    // A failed I2C read typically returns 0xff for every byte
+    memset(block, 0xff, sizeof(block));
+    Log.info("decodeTimeBlock of 0xff values returns %d (expected 0)", AB1805::decodeTimeBlock(block, values));
+
+    (void) valid;
+
+    (void) sink;
+}
@@ -0,0 +1,66 @@
+#include "AB1805_RK.h"
+
+SYSTEM_THREAD(ENABLED);
+SYSTEM_MODE(SEMI_AUTOMATIC);
+
+SerialLogHandler logHandler;
+
+// This example uses the FOUT/nIRQ interrupt instead of polling REG_STATUS. A repeating
+// alarm fires at 30 seconds past every minute and a repeating countdown timer fires 
+// every 10 seconds. AB1805::loop() reads REG_STATUS once after each interrupt and calls
+// the handler for each event.
+
+AB1805 ab1805(Wire);
+
+void alarmHandler(uint8_t status);
+void timerHandler(uint8_t status);
+
+void setup() {
+    // Optional: Enable to make it easier to see debug USB serial messages at startup
+    waitFor(Serial.isConnected, 15000);
+    delay(1000);
+
+    // The sample board has D8 (Argon/Boron) or D10 (Photon 2) connected to FOUT
+    ab1805.withFOUT(WKP)
+        .withEventInterrupt(60000)
+        .withEventHandler(AB1805::REG_STATUS_ALM, alarmHandler)
+        .withEventHandler(AB1805::REG_STATUS_TIM, timerHandler)
+        .setup();
+
+    // Reset the AB1805 configuration to default values
+    ab1805.resetConfig();
+
+    // Alarm when tm_sec matches (once per minute)
+    struct tm alarmTime = {0};
+    alarmTime.tm_sec = 30;
+    ab1805.repeatingInterrupt(&alarmTime, AB1805::REG_TIMER_CTRL_RPT_SEC);
+
+    // repeatingInterrupt() sets FOUT/nIRQ to the alarm only (nAIRQ), so switch it to nIRQ
+    // so the countdown timer interrupt is also on FOUT
+    ab1805.maskRegister(AB1805::REG_CTRL_2, ~AB1805::REG_CTRL_2_OUT1S_MASK, AB1805::REG_CTRL_2_OUT1S_nIRQ);
+
+    // Countdown timer, 10 seconds, with automatic reload and interrupt enabled. The timer is 
+    // reloaded one tick after reaching 0, so the repeat period is REG_TIMER_INITIAL + 1.
+    ab1805.writeRegister(AB1805::REG_TIMER_INITIAL, 10 - 1);
+    ab1805.writeRegister(AB1805::REG_TIMER, 10);
+    ab1805.setRegisterBit(AB1805::REG_INT_MASK, AB1805::REG_INT_MASK_TIE);
+    // REG_TIMER_CTRL also contains the alarm repeat setting, so only the timer bits are changed
+    ab1805.maskRegister(AB1805::REG_TIMER_CTRL, AB1805::REG_TIMER_CTRL_RPT_MASK, 
+        AB1805::REG_TIMER_CTRL_TE | AB1805::REG_TIMER_CTRL_TRPT | AB1805::REG_TIMER_CTRL_TFS_1);
+
+    Particle.connect();
+}
+
+void loop() {
+    ab1805.loop();
+}
+
+void alarmHandler(uint8_t status) {
+    time_t time;
+    ab1805.getRtcAsTime(time);
+    Log.info("alarm status=0x%02x %s", status, Time.format(time, TIME_FORMAT_DEFAULT).c_str());
+}
+
+void timerHandler(uint8_t status) {
+    Log.info("countdown timer status=0x%02x", status);
+}
@@ -10,12 +10,62 @@ static Logger _log("app.ab1805");
 
 AB1805 *AB1805::instance = 0;
 
+// Register image written by resetConfig(), starting at REG_STATUS (0x0f) and ending at REG_OCTRL (0x30).
+// Only the ranges listed in resetBlocks are written; the other entries are placeholders.
+static const uint8_t RESET_IMAGE_FIRST = AB1805::REG_STATUS;
+static constexpr uint8_t resetImage[AB1805::REG_OCTRL - RESET_IMAGE_FIRST + 1] = {
+    AB1805::REG_STATUS_DEFAULT,         // 0x0f
+    AB1805::REG_CTRL_1_DEFAULT,         // 0x10
+    AB1805::REG_CTRL_2_DEFAULT,         // 0x11
+    AB1805::REG_INT_MASK_DEFAULT,       // 0x12
+    AB1805::REG_SQW_DEFAULT,            // 0x13
+    0x00, 0x00, 0x00,                   // 0x14 - 0x16 calibration (not reset)
+    AB1805::REG_SLEEP_CTRL_DEFAULT,     // 0x17
+    AB1805::REG_TIMER_CTRL_DEFAULT,     // 0x18
+    AB1805::REG_TIMER_DEFAULT,          // 0x19
+    AB1805::REG_TIMER_INITIAL_DEFAULT,  // 0x1a
+    AB1805::REG_WDT_DEFAULT,            // 0x1b
+    AB1805::REG_OSC_CTRL_DEFAULT,       // 0x1c
+    0x00, 0x00, 0x00,                   // 0x1d - 0x1f (not reset)
+    AB1805::REG_TRICKLE_DEFAULT,        // 0x20
+    AB1805::REG_BREF_CTRL_DEFAULT,      // 0x21
+    0x00, 0x00, 0x00, 0x00,             // 0x22 - 0x25 (not reset)
+    AB1805::REG_AFCTRL_DEFAULT,         // 0x26
+    AB1805::REG_BATMODE_IO_DEFAULT,     // 0x27
+    0x00, 0x00, 0x00, 0x00,             // 0x28 - 0x2b (read-only)
+    0x00, 0x00, 0x00, 0x00,             // 0x2c - 0x2f (read-only)
+    AB1805::REG_OCTRL_DEFAULT           // 0x30
+};
+
+// Contiguous ranges of resetImage that are written, in order. Each write is one I2C transaction.
+// If key is non-zero, the range is written by writeRegistersWithKey() instead, one register at a
+// time with REG_CONFIG_KEY written before each, as the key only applies to the write transaction
+// immediately following it.
+typedef struct {
+    uint8_t key;
+    uint8_t regAddr;
+    uint8_t num;
+} ResetBlock;
+
+static constexpr ResetBlock resetBlocks[] = {
+    { 0, AB1805::REG_STATUS, 5 },                                   // 0x0f - 0x13
+    { 0, AB1805::REG_SLEEP_CTRL, 5 },                               // 0x17 - 0x1b
+    { AB1805::REG_CONFIG_KEY_OSC_CTRL, AB1805::REG_OSC_CTRL, 1 },   // 0x1c
+    { AB1805::REG_CONFIG_KEY_OTHER, AB1805::REG_TRICKLE, 2 },       // 0x20 - 0x21
+    { AB1805::REG_CONFIG_KEY_OTHER, AB1805::REG_AFCTRL, 2 },        // 0x26 - 0x27
+    { AB1805::REG_CONFIG_KEY_OTHER, AB1805::REG_OCTRL, 1 }          // 0x30
+};
+
 
 AB1805::AB1805(TwoWire &wire, uint8_t i2cAddr) : wire(wire), i2cAddr(i2cAddr) {
     instance = this;
 }
 
 AB1805::~AB1805() {
+    if (watchdogTimer) {
+        watchdogTimer->stop();
+        delete watchdogTimer;
+    }
 
 }
 
@@ -26,35 +76,137 @@ void AB1805::setup(bool callBegin) {
     }
     
     if (detectChip()) {
+        if (registerCacheEnabled) {
+            loadRegisterCache();
+        }
+
+        if (calibrationEnabled) {
+            loadCalibration();
+        }
+
+        if (bootJournalEnabled) {
+            loadBootJournal();
+        }
+
         updateWakeReason();
 
+        if (deepPowerDownRecordEnabled) {
+            loadDeepPowerDownRecord();
+        }
+
+        if (wakeReason == WakeReason::DEEP_POWER_DOWN && (wakeCauses & WAKE_CAUSE_ALM) != 0) {
+            // The RPT_MON alarm from deepPowerDownFor() would otherwise match again in a year. 
+            // With withAlarmTimers(), loadAlarmTimers() below sets it again for the next timer.
+            clearRepeatingInterrupt();
+        }
+
+        if (supervisorEnabled) {
+            loadWatchdogSupervisor();
+        }
+
+        if (snapshotEnabled) {
+            loadWatchdogSnapshot();
+            if (!watchdogTimerEnabled) {
+                _log.error("withWatchdogSnapshot requires withWatchdogRefreshTimer");
+                snapshotEnabled = false;
+                if (watchdogRegValue) {
+                    // setWDT() was called before setup(), switch back to reset mode
+                    watchdogRegValue |= REG_WDT_RESET;
+                    refreshWDT();
+                }
+            }
+        }
+
+        if (watchdogTimerEnabled && !watchdogTimer) {
+            loopMillis = millis();
+            watchdogTimer = new Timer(1000, &AB1805::watchdogTimerCallback, *this);
+            if (watchdogUpdatePeriod) {
+                // setWDT() was called before setup()
+                watchdogTimer->changePeriod(watchdogUpdatePeriod);
+            }
+        }
+
+        if (snapshotEnabled && !watchdogThread) {
+            watchdogThread = new Thread("ab1805wdt", [this]() { watchdogThreadFunction(); }, OS_THREAD_PRIORITY_DEFAULT, WATCHDOG_THREAD_STACK_SIZE);
+        }
+
         // If we've set the time in the RTC, then the WRTC bit will be 0.
-        // On power-up from cold, it's 1
-        if (isBitClear(REG_CTRL_1, REG_CTRL_1_WRTC) && !Time.isValid()) {
+        // On power-up from cold, it's 1 and getRtcAsTime returns false.
+        time_t time;
+        if (!Time.isValid() && getRtcAsTime(time)) {
             // Set system clock from RTC
-            time_t time;
-
-            getRtcAsTime(time);
             Time.setTime(time);
 
             _log.info("set system clock from RTC %s", Time.format(time, TIME_FORMAT_DEFAULT).c_str());
         }
+
+        if (cachedClockEnabled) {
+            syncCachedClock();
+        }
+
+        if (alarmTimersEnabled) {
+            loadAlarmTimers();
+
+            // Timers that expired while powered down are counted as a wake on the first pass
+            alarmTimerWakePending = true;
+        }
+
+        if (eventInterruptEnabled) {
+            if (foutPin != PIN_INVALID) {
+                attachInterrupt(foutPin, &AB1805::foutInterrupt, this, FALLING);
+
+                // If nIRQ is already asserted there won't be a falling edge
+                if (digitalRead(foutPin) == LOW) {
+                    eventPending = true;
+                }
+            }
+            else {
+                _log.error("withEventInterrupt requires withFOUT");
+            }
+        }
     }
     else {
         _log.error("failed to detect AB1805");
     }
 
-    System.on(reset, systemEventStatic);
+    system_event_t events = reset;
+    if (systemWatchdogBudget[WATCHDOG_PHASE_NETWORK_CONNECT]) {
+        events |= network_status;
+    }
+    if (systemWatchdogBudget[WATCHDOG_PHASE_CLOUD_CONNECT]) {
+        events |= cloud_status;
+    }
+    if (systemWatchdogBudget[WATCHDOG_PHASE_FIRMWARE_UPDATE]) {
+        events |= firmware_update;
+    }
+    System.on(events, systemEventStatic);
 }
 
 void AB1805::loop() {
+    loopMillis = millis();
+
     // The check for Particle.connected is because while connecting to the cloud, timeSyncedLast
     // can block until the connection is complete.
+    if (calibrationEnabled && Time.isValid() && Particle.connected()) {
+        time_t syncedTime;
+        unsigned long syncedMillis = Particle.timeSyncedLast(syncedTime);
+        if (syncedMillis != 0 && syncedMillis != calibrationSyncMillis) {
+            // This must be done before the RTC is set from the new time below
+            calibrationSyncMillis = syncedMillis;
+            updateCalibration(syncedTime, syncedMillis);
+        }
+    }
+
     if (!timeSet && Time.isValid() && Particle.connected() && Particle.timeSyncedLast() != 0) {
         timeSet = true;
 
-        time_t time = Time.now();
-        setRtcFromTime(time);
+        time_t time;
+        if (alignedRtcSet) {
+            setRtcFromSystemAligned();
+        }
+        else {
+            setRtcFromTime(Time.now());
+        }
 
         time = 0;
         getRtcAsTime(time);
@@ -62,12 +214,42 @@ void AB1805::loop() {
 
     }
 
-    if (watchdogUpdatePeriod) {
-        if (millis() - lastWatchdogMillis >= watchdogUpdatePeriod) {
+    if (cachedClockEnabled) {
+        if (cachedClockNeedsSync()) {
+            syncCachedClock();
+        }
+    }
+
+    if (eventInterruptEnabled) {
+        if (eventPending || (eventPollPeriod != 0 && millis() - lastEventMillis >= eventPollPeriod)) {
+            processEvents();
+        }
+    }
+
+    if (alarmTimersEnabled && alarmTimerQueue.numTimers != 0 && Time.isValid() && (time_t)alarmTimerQueue.timers[0].deadline <= Time.now()) {
+        serviceAlarmTimers();
+    }
+    else {
+        // Nothing was due after the boot or wake, so a later timer run while awake is not a wake
+        alarmTimerWakePending = false;
+    }
+
+    if (scheduleEnabled && Time.isValid() && scheduleNext <= Time.now()) {
+        serviceSchedule();
+    }
+
+    if (supervisorEnabled && watchdogTimerEnabled) {
+        // Changes from the timer callback are logged and saved here
+        saveWatchdogSupervisor();
+    }
+
+    if (watchdogUpdatePeriod && !watchdogTimerEnabled) {
+        // With the supervisor, the refresh is retried on every loop until all clients are healthy
+        if (millis() - lastWatchdogMillis >= watchdogUpdatePeriod && (!supervisorEnabled || isWatchdogBudgetActive() || checkWatchdogClients())) {
             lastWatchdogMillis = millis();
 
             // Reset the watchdog timer
-            setWDT();
+            refreshWDT();
         }
     }
 }
@@ -123,381 +305,2515 @@ bool AB1805::usingRCOscillator() {
 }
 
 bool AB1805::resetConfig(uint32_t flags) {
+    static const char *errorMsg = "failure in resetConfig %d";
+    bool bResult = true;
+
     _log.trace("resetConfig(0x%08lx)", flags);
 
-    wire.lock();
+    uint8_t image[sizeof(resetImage)];
+    memcpy(image, resetImage, sizeof(image));
 
-    // Reset configuration registers to default values
-    writeRegister(REG_STATUS, REG_STATUS_DEFAULT, false);
-    writeRegister(REG_CTRL_1, REG_CTRL_1_DEFAULT, false);
-    writeRegister(REG_CTRL_2, REG_CTRL_2_DEFAULT, false);
-    writeRegister(REG_INT_MASK, REG_INT_MASK_DEFAULT, false);
-    writeRegister(REG_SQW, REG_SQW_DEFAULT, false);
-    writeRegister(REG_SLEEP_CTRL, REG_SLEEP_CTRL_DEFAULT, false);
+    wire.lock();
 
     if ((flags & RESET_PRESERVE_REPEATING_TIMER) != 0) {
-        maskRegister(REG_TIMER_CTRL, ~REG_TIMER_CTRL_RPT_MASK, REG_TIMER_CTRL_DEFAULT & ~REG_TIMER_CTRL_RPT_MASK, false);
-    }  
-    else {
-        writeRegister(REG_TIMER_CTRL, REG_TIMER_CTRL_DEFAULT, false);
+        uint8_t timerCtrl;
+        bResult = readRegister(REG_TIMER_CTRL, timerCtrl, false);
+        if (bResult) {
+            image[REG_TIMER_CTRL - RESET_IMAGE_FIRST] = (REG_TIMER_CTRL_DEFAULT & ~REG_TIMER_CTRL_RPT_MASK) | (timerCtrl & REG_TIMER_CTRL_RPT_MASK);
+        }
+        else {
+            _log.error(errorMsg, __LINE__);
+        }
     }
 
-    writeRegister(REG_TIMER, REG_TIMER_DEFAULT, false);
-    writeRegister(REG_TIMER_INITIAL, REG_TIMER_INITIAL_DEFAULT, false);
-    writeRegister(REG_WDT, REG_WDT_DEFAULT, false);
-
-    uint8_t oscCtrl = REG_OSC_CTRL_DEFAULT;
     if ((flags & RESET_DISABLE_XT) != 0) {
         // If disabling XT oscillator, set OSEL to 1 (RC oscillator)
         // Also enable FOS so if the XT oscillator fails, it will switch to RC (just in case)
         // and ACAL to 0 (however REG_OSC_CTRL_DEFAULT already sets ACAL to 0)
-        oscCtrl |= REG_OSC_CTRL_OSEL | REG_OSC_CTRL_FOS;
+        image[REG_OSC_CTRL - RESET_IMAGE_FIRST] |= REG_OSC_CTRL_OSEL | REG_OSC_CTRL_FOS;
+    }
+
+    for(const ResetBlock &block : resetBlocks) {
+        if (!bResult) {
+            break;
+        }
+        const uint8_t *values = &image[block.regAddr - RESET_IMAGE_FIRST];
+        if (block.key != 0) {
+            bResult = writeRegistersWithKey(block.key, block.regAddr, values, block.num, false);
+        }
+        else {
+            bResult = writeRegisters(block.regAddr, values, block.num, false);
+        }
+        if (!bResult) {
+            _log.error(errorMsg, __LINE__);
+        }
     }
-    writeRegister(REG_OSC_CTRL, oscCtrl, false);
-    writeRegister(REG_TRICKLE, REG_TRICKLE_DEFAULT, false);
-    writeRegister(REG_BREF_CTRL, REG_BREF_CTRL_DEFAULT, false);
-    writeRegister(REG_AFCTRL, REG_AFCTRL_DEFAULT, false);
-    writeRegister(REG_BATMODE_IO, REG_BATMODE_IO_DEFAULT, false);
-    writeRegister(REG_OCTRL, REG_OCTRL_DEFAULT, false);
 
     wire.unlock();
 
-    return true;
+    return bResult;
 }
 
 
 bool AB1805::updateWakeReason() {
     static const char *errorMsg = "failure in updateWakeReason %d";
 
-    uint8_t status;
-    bool bResult = readRegister(REG_STATUS, status);
+    // REG_STATUS through REG_OSC_STATUS in one read
+    uint8_t array[WAKE_STATUS_BLOCK_SIZE];
+
+    wire.lock();
+
+    bool bResult = readRegisters(REG_STATUS, array, sizeof(array), false);
     if (!bResult) {
+        wire.unlock();
         _log.error(errorMsg, __LINE__);
         return false;
     }
 
+    uint8_t status = array[0];
+    uint8_t sleepCtrl = array[REG_SLEEP_CTRL - REG_STATUS];
+
+    wakeCauses = wakeCausesFromRegisters(array);
+
+    // All of the pending causes are cleared by writing 0. CB and BAT are written back unchanged.
+    uint8_t clearMask = (uint8_t)(wakeCauses & WAKE_CAUSE_STATUS_MASK);
+    if (clearMask != 0) {
+        bResult = writeRegister(REG_STATUS, status & ~clearMask, false);
+        if (!bResult) {
+            _log.error(errorMsg, __LINE__);
+        }
+    }
+
+    if ((wakeCauses & WAKE_CAUSE_OSC_FAIL) != 0) {
+        // OF is set on every cold power-up, so it's cleared to report only new failures. XTCAL is unchanged.
+        uint8_t oscStatus = array[REG_OSC_STATUS - REG_STATUS];
+        if (!writeRegister(REG_OSC_STATUS, oscStatus & ~REG_OSC_STATUS_OF, false)) {
+            _log.error(errorMsg, __LINE__);
+            bResult = false;
+        }
+    }
+
+    wire.unlock();
+
     const char *reason = 0;
 
-    if ((status & REG_STATUS_WDT) != 0) {
+    if ((wakeCauses & WAKE_CAUSE_WDT) != 0) {
         reason = "WATCHDOG";
         wakeReason = WakeReason::WATCHDOG;
-        clearRegisterBit(REG_STATUS, REG_STATUS_WDT);
     }
-    else if (isBitSet(REG_SLEEP_CTRL, REG_SLEEP_CTRL_SLST)) {
+    else if ((wakeCauses & WAKE_CAUSE_SLST) != 0) {
         reason = "DEEP_POWER_DOWN";
         wakeReason = WakeReason::DEEP_POWER_DOWN;
     }    
-    else if ((status & REG_STATUS_TIM) != 0) {
+    else if ((wakeCauses & WAKE_CAUSE_TIM) != 0) {
         reason = "COUNTDOWN_TIMER";
         wakeReason = WakeReason::COUNTDOWN_TIMER;
-        clearRegisterBit(REG_STATUS, REG_STATUS_TIM);            
     }
-    else if ((status & REG_STATUS_ALM) != 0) {
+    else if ((wakeCauses & WAKE_CAUSE_ALM) != 0) {
         reason = "ALARM";
         wakeReason = WakeReason::ALARM;
-        clearRegisterBit(REG_STATUS, REG_STATUS_ALM);            
     }
 
-    if (reason) {
-        _log.info("wake reason = %s", reason);
+    if ((wakeCauses & WAKE_CAUSE_ALM) != 0) {
+        // ALM is cleared here, so processEvents() won't see it after STOP mode sleep
+        alarmTimerWakePending = true;
     }
 
-    return true;
-}
-
-bool AB1805::setWDT(int seconds) {
-    bool bResult = false;
-    _log.info("setWDT %d", seconds);
-
-    if (seconds < 0) {
-        seconds = watchdogSecs;
+    if (reason) {
+        _log.info("wake reason = %s causes=0x%04x", reason, wakeCauses);
     }
 
-    if (seconds == 0) {
-        // Disable WDT
-        bResult = writeRegister(REG_WDT, 0x00);
-
-        _log.trace("watchdog cleared bResult=%d", bResult);
-
-        watchdogSecs = 0;
-        watchdogUpdatePeriod = 0;
-    } 
-    else {
-        // Use 1/4 Hz clock
-        int fourSecs = seconds / 4;
-        if (fourSecs < 1) {
-            fourSecs = 1;
-        }
-        if (fourSecs > 31) {
-            fourSecs = 31;
-        }
-        bResult = writeRegister(REG_WDT, REG_WDT_RESET | (fourSecs << 2) | REG_WDT_WRB_1_4_HZ);
-
-        _log.trace("watchdog set fourSecs=%d bResult=%d", fourSecs, bResult);
-
-        watchdogSecs = seconds;
-
-        // Update watchdog half way through period
-        watchdogUpdatePeriod = (fourSecs * 2000);
+    if (bootJournalHeader.magic == BOOT_JOURNAL_MAGIC) {
+        addBootJournalRecord(status, sleepCtrl);
     }
 
-    return bResult;      
+    return bResult;
 }
 
-bool AB1805::setRtcFromSystem() {
-    if (Time.isValid()) {
-        return setRtcFromTime(Time.now());
+// [static]
+uint16_t AB1805::wakeCausesFromRegisters(const uint8_t *array) {
+    uint16_t causes = array[0] & WAKE_CAUSE_STATUS_MASK;
+
+    if ((array[REG_SLEEP_CTRL - REG_STATUS] & REG_SLEEP_CTRL_SLST) != 0) {
+        causes |= WAKE_CAUSE_SLST;
     }
-    else {
-        return false;
+    if ((array[REG_OSC_STATUS - REG_STATUS] & REG_OSC_STATUS_OF) != 0) {
+        causes |= WAKE_CAUSE_OSC_FAIL;
     }
+    return causes;
 }
 
-bool AB1805::setRtcFromTime(time_t time, bool lock) {
-    struct tm *tm = gmtime(&time);
-    return setRtcFromTm(tm, lock);
-}
+bool AB1805::loadBootJournal() {
+    static const char *errorMsg = "failure in loadBootJournal %d";
 
-bool AB1805::setRtcFromTm(const struct tm *timeptr, bool lock) {
-    static const char *errorMsg = "failure in setRtcFromTm %d";
-    uint8_t array[8];
+    bool bResult = readRam(bootJournalRamAddr, (uint8_t *)&bootJournalHeader, sizeof(BootJournalHeader));
+    if (!bResult) {
+        _log.error(errorMsg, __LINE__);
+        bootJournalHeader.magic = 0;
+        return false;
+    }
 
-    _log.info("setRtcAsTm %s", tmToString(timeptr).c_str());
+    if (bootJournalHeader.magic != BOOT_JOURNAL_MAGIC || bootJournalHeader.capacity != bootJournalCapacity || 
+        bootJournalHeader.count > bootJournalCapacity || bootJournalHeader.next >= bootJournalCapacity) {
+        _log.info("boot journal initialized capacity=%u", bootJournalCapacity);
+        bootJournalHeader = {};
+        bootJournalHeader.magic = BOOT_JOURNAL_MAGIC;
+        bootJournalHeader.capacity = bootJournalCapacity;
+    }
+    bootJournalHeader.bootCount++;
 
-    if (lock) {
-        wire.lock();
+    bResult = writeRam(bootJournalRamAddr, (const uint8_t *)&bootJournalHeader, sizeof(BootJournalHeader));
+    if (!bResult) {
+        _log.error(errorMsg, __LINE__);
+        bootJournalHeader.magic = 0;
     }
+    return bResult;
+}
 
-    array[0] = 0x00; // hundredths
-    tmToRegisters(timeptr, &array[1], true);
+bool AB1805::addBootJournalRecord(uint8_t status, uint8_t sleepCtrl) {
+    static const char *errorMsg = "failure in addBootJournalRecord %d";
 
-    // Can only write RTC registers when WRTC is 1
-    bool bResult = setRegisterBit(REG_CTRL_1, REG_CTRL_1_WRTC);
-    if (bResult) {
-        bResult = writeRegisters(REG_HUNDREDTH, array, sizeof(array), false);
-        if (bResult) {
-            // Clear the REG_CTRL_1_WRTC after setting the RTC.
-            // Aside from being a good thing to do, that's how we know we've set it.
-            clearRegisterBit(REG_CTRL_1, REG_CTRL_1_WRTC);
-        }
-        else {
-            _log.error(errorMsg, __LINE__);
-        }
+    BootJournalRecord record = {};
+    record.status = status;
+    record.sleepCtrl = sleepCtrl;
+    record.info = (uint8_t)(((uint8_t)wakeReason & 0x07) | (bootJournalHeader.bootCount << 3));
+
+    uint8_t array[TIME_BLOCK_SIZE];
+    uint8_t rtcStatus;
+    if (readRtcRegisters(array, rtcStatus)) {
+        record.time = (uint32_t)registersToTime(&array[REG_SECOND]);
+        record.hundredths = (uint8_t)bcdToValue(array[REG_HUNDREDTH]);
     }
-    else {
+
+    size_t addr = bootJournalRamAddr + sizeof(BootJournalHeader) + bootJournalHeader.next * sizeof(BootJournalRecord);
+    bool bResult = writeRam(addr, (const uint8_t *)&record, sizeof(BootJournalRecord));
+    if (!bResult) {
         _log.error(errorMsg, __LINE__);
+        return false;
     }
 
-    if (lock) {
-        wire.unlock();
+    bootJournalHeader.next = (uint8_t)((bootJournalHeader.next + 1) % bootJournalHeader.capacity);
+    if (bootJournalHeader.count < bootJournalHeader.capacity) {
+        bootJournalHeader.count++;
     }
 
+    bResult = writeRam(bootJournalRamAddr, (const uint8_t *)&bootJournalHeader, sizeof(BootJournalHeader));
+    if (!bResult) {
+        _log.error(errorMsg, __LINE__);
+    }
     return bResult;
 }
 
-bool AB1805::getRtcAsTime(time_t &time) {
-    struct tm tmstruct;
+size_t AB1805::readBootJournal(BootJournalRecord *records, size_t maxRecords) {
+    static const char *errorMsg = "failure in readBootJournal %d";
 
-    bool bResult = getRtcAsTm(&tmstruct);
-    if (bResult) {
-        // Technically mktime is local time, not UTC. However, the standard library
-        // is set at +0000 so the local time happens to also be UTC. This is the
-        // case even if Time.zone() is called, which only affects the Wiring
-        // API and does not affect the standard time library.
-        time = mktime(&tmstruct);
+    if (bootJournalHeader.magic != BOOT_JOURNAL_MAGIC) {
+        return 0;
     }
 
-    return bResult;   
-}
-
-bool AB1805::getRtcAsTm(struct tm *timeptr) {
-    uint8_t array[8];
-    bool bResult = false;
+    size_t num = bootJournalHeader.count;
+    if (num > maxRecords) {
+        num = maxRecords;
+    }
+    if (num == 0) {
+        return 0;
+    }
 
-    // If we've set the time in the RTC, then the WTC bit will be 0.
-    // On power-up from cold, it's 1
-    if (isBitClear(REG_CTRL_1, REG_CTRL_1_WRTC)) {
-        bResult = readRegisters(REG_HUNDREDTH, array, sizeof(array));
-        if (bResult) {
-            registersToTm(&array[1], timeptr, true);
+    // Oldest requested record, which may wrap around to the end of the circular buffer
+    size_t capacity = bootJournalHeader.capacity;
+    size_t first = (bootJournalHeader.next + capacity - num) % capacity;
+    size_t firstCount = capacity - first;
+    if (firstCount > num) {
+        firstCount = num;
+    }
 
-            _log.info("getRtcAsTm %s", tmToString(timeptr).c_str());
-        }
+    size_t recordsAddr = bootJournalRamAddr + sizeof(BootJournalHeader);
+    bool bResult = readRam(recordsAddr + first * sizeof(BootJournalRecord), (uint8_t *)records, firstCount * sizeof(BootJournalRecord));
+    if (bResult && firstCount < num) {
+        bResult = readRam(recordsAddr, (uint8_t *)&records[firstCount], (num - firstCount) * sizeof(BootJournalRecord));
     }
     if (!bResult) {
-        memset(timeptr, 0, sizeof(*timeptr));
+        _log.error(errorMsg, __LINE__);
+        return 0;
     }
-
-    return bResult;
+    return num;
 }
 
+bool AB1805::clearBootJournal() {
+    static const char *errorMsg = "failure in clearBootJournal %d";
 
-#if 0
-bool AB1805::testEN() {
-    _log.info("testEN()");
-
-    // Test function to drive EN low (device power off) by setting PSW/nIRQ2 high
-    // Note: Only way to recover from this is to depower the AB1805!
+    if (bootJournalHeader.magic != BOOT_JOURNAL_MAGIC) {
+        return false;
+    }
+    bootJournalHeader.count = 0;
+    bootJournalHeader.next = 0;
 
-    // Control PWR/nIRQ2 using OUTB
-    maskRegister(REG_CTRL_2, ~REG_CTRL_2_OUT2S_MASK, REG_CTRL_2_OUT2S_OUTB);
+    bool bResult = writeRam(bootJournalRamAddr, (const uint8_t *)&bootJournalHeader, sizeof(BootJournalHeader));
+    if (!bResult) {
+        _log.error(errorMsg, __LINE__);
+    }
+    return bResult;
+}
 
-    // In order to change OUTB, you need to clear LKO2. This is done by setting
-    // Oscillator Status to 0. This will also clear the OF (oscillator failure)
-    // but, but this is OK.
-    writeRegister(REG_OSC_STATUS, 0x00);
+AB1805 &AB1805::withEventHandler(uint8_t statusFlags, EventHandler handler) {
+    for(size_t bit = 0; bit < sizeof(eventHandlers) / sizeof(eventHandlers[0]); bit++) {
+        if ((statusFlags & (1 << bit)) != 0) {
+            eventHandlers[bit] = handler;
+        }
+    }
+    return *this;
+}
 
-    // Set PWR2 to 0 (default 1), this allows PWR/nIRQ2 to be normal open-drain 
-    // Set OUTB to 1 (default 0), this should set EN low via the N-channel MOSFET
-    maskRegister(REG_CTRL_1, ~REG_CTRL_1_PWR2, REG_CTRL_1_OUTB);
+bool AB1805::processEvents() {
+    static const char *errorMsg = "failure in processEvents %d";
+    uint8_t status;
 
-    return true;
-}  
-#endif
+    // Cleared before reading so an interrupt during processing causes another call
+    eventPending = false;
+    lastEventMillis = millis();
 
-bool AB1805::interruptAtTime(time_t time) {
-    struct tm *tm = gmtime(&time);
-    return interruptAtTm(tm);
-}
+    wire.lock();
 
-bool AB1805::interruptAtTm(struct tm *timeptr) {
-    return repeatingInterrupt(timeptr, REG_TIMER_CTRL_RPT_DATE);
-}
+    bool bResult = readRegister(REG_STATUS, status, false);
+    uint8_t events = status & EVENT_FLAGS_MASK;
+    if (snapshotEnabled) {
+        // The watchdog timer callback and thread handle WIRQ and clear WDT
+        events &= ~REG_STATUS_WDT;
+    }
+    if (bResult && events != 0) {
+        // Event flags are cleared by writing 0. CB and BAT are written back unchanged.
+        bResult = writeRegister(REG_STATUS, status & ~events, false);
+    }
 
-bool AB1805::repeatingInterrupt(struct tm *timeptr, uint8_t rptValue) {
-    static const char *errorMsg = "failure in repeatingInterrupt %d";
-    bool bResult;
+    wire.unlock();
 
-    // Disable watchdog
-    bResult = setWDT(0);
     if (!bResult) {
         _log.error(errorMsg, __LINE__);
         return false;
     }
 
-    // Clear any existing alarm (ALM) interrupt in status register
-    bResult = clearRegisterBit(REG_STATUS, REG_STATUS_ALM);            
-    if (!bResult) {
-        _log.error(errorMsg, __LINE__);
-        return false;
+    if (countdownTimerMs != 0 && (events & REG_STATUS_TIM) != 0 && continueCountdownTimer()) {
+        // Intermediate segment of setCountdownTimerMillis(), not passed to the handler
+        events &= ~REG_STATUS_TIM;
     }
 
-    // Set alarm registers
-    uint8_t array[7];
-
-    array[0] = 0x00; // hundredths
-    tmToRegisters(timeptr, &array[1], false);
+    if (periodicTickEnabled) {
+        uint32_t ticks = 0;
+        if (periodicTickPulse) {
+            ATOMIC_BLOCK() {
+                ticks = periodicTickPulses;
+                periodicTickPulses = 0;
+            }
+        }
+        else
+        if ((events & REG_STATUS_TIM) != 0) {
+            // Only one TIM can be pending, so count the periods that elapsed to find missed ticks.
+            // Rounded down so latency of less than a period is not a miss, and measured from the
+            // last detection so the latency and clock drift do not accumulate.
+            unsigned long now = micros();
+            ticks = (uint32_t)((now - periodicTickLastMicros) / periodicTickPeriodUs);
+            if (ticks == 0) {
+                ticks = 1;
+            }
+            periodicTickLastMicros = now;
+        }
+        events &= ~REG_STATUS_TIM;
 
-    bResult = writeRegisters(REG_HUNDREDTH_ALARM, array, sizeof(array));
-    if (!bResult) {
-        _log.error(errorMsg, __LINE__);
-        return false;
+        if (ticks != 0) {
+            periodicTickCount += ticks;
+            periodicTickMissed += ticks - 1;
+            if (periodicTickHandler) {
+                periodicTickHandler(ticks);
+            }
+        }
     }
 
-#if 1
-    {
-        // TESTING
-        uint8_t array2[7];
+    if (events != 0) {
+        _log.trace("processEvents status=0x%02x", status);
 
-        bResult = readRegisters(REG_HUNDREDTH_ALARM, array2, sizeof(array2));
-        _log.info("alarm (first) current (second)");
+        for(size_t bit = 0; bit < sizeof(eventHandlers) / sizeof(eventHandlers[0]); bit++) {
+            if ((events & (1 << bit)) != 0 && eventHandlers[bit]) {
+                eventHandlers[bit](status);
+            }
+        }
+    }
+
+    if (alarmTimersEnabled && (events & REG_STATUS_ALM) != 0) {
+        alarmTimerWakePending = true;
+        serviceAlarmTimers();
+    }
+
+    if (scheduleEnabled && (events & REG_STATUS_ALM) != 0) {
+        serviceSchedule();
+    }
+
+    return true;
+}
+
+void AB1805::foutInterrupt() {
+    if (periodicTickPulse) {
+        periodicTickPulses++;
+    }
+    eventPending = true;
+}
+
+bool AB1805::setWDT(int seconds) {
+    if (seconds < 0) {
+        // Service the watchdog using the previous setting
+        return refreshWDT();
+    }
+
+    _log.info("setWDT %d", seconds);
+
+    return setWDTMillis((uint32_t)seconds * 1000);
+}
+
+bool AB1805::setWDTMillis(uint32_t ms) {
+    if (watchdogBudgetSavedMillis != 0) {
+        // Set during a watchdog budget phase, so this is the duration restored when the last phase ends
+        watchdogBudgetSavedMillis = ms;
+        if (ms != 0 && ms < watchdogMillis) {
+            // Keep the longer duration until then
+            return refreshWDT();
+        }
+    }
+    return writeWDTMillis(ms);
+}
+
+bool AB1805::writeWDTMillis(uint32_t ms) {
+    bool bResult = false;
+
+    if (ms == 0) {
+        // Disable WDT
+        bResult = writeRegister(REG_WDT, 0x00);
+
+        _log.trace("watchdog cleared bResult=%d", bResult);
+
+        watchdogMillis = 0;
+        watchdogRegValue = 0;
+        watchdogUpdatePeriod = 0;
+    } 
+    else {
+        // With withWatchdogSnapshot(), the watchdog interrupts (WIRQ) and checkWatchdogInterrupt() sets the reset
+        watchdogRegValue = (snapshotEnabled ? 0 : REG_WDT_RESET) | watchdogRegisterValue(ms, watchdogMillis);
+        bResult = writeRegister(REG_WDT, watchdogRegValue);
+        if (bResult) {
+            watchdogRefreshMillis = (uint32_t)millis();
+        }
+
+        _log.trace("watchdog set reg=0x%02x ms=%lu bResult=%d", watchdogRegValue, (unsigned long)watchdogMillis, bResult);
+
+        // Update watchdog half way through period
+        watchdogUpdatePeriod = watchdogMillis / 2;
+    }
+
+    if (watchdogTimer) {
+        if (watchdogUpdatePeriod) {
+            // Also starts the timer
+            watchdogTimer->changePeriod(watchdogUpdatePeriod);
+        }
+        else {
+            watchdogTimer->stop();
+        }
+    }
+
+    return bResult;      
+}
+
+bool AB1805::refreshWDT() {
+    if (watchdogRegValue == 0 || watchdogResetArmed) {
+        return true;
+    }
+    bool bResult = writeRegister(REG_WDT, watchdogRegValue);
+    if (bResult) {
+        watchdogRefreshMillis = (uint32_t)millis();
+    }
+    return bResult;
+}
+
+void AB1805::watchdogTimerCallback() {
+    uint8_t flags = 0;
+
+    if (isWatchdogBudgetActive()) {
+        // Blocking for longer than the watchdog duration is expected
+    }
+    else
+    if (watchdogLoopTimeout != 0 && millis() - loopMillis > watchdogLoopTimeout) {
+        // The loop thread is not running, so let the watchdog reset the device
+        flags = WATCHDOG_SNAPSHOT_LOOP_HUNG;
+    }
+    else
+    if (supervisorEnabled && !updateWatchdogClients()) {
+        flags = WATCHDOG_SNAPSHOT_CLIENT_LATE;
+    }
+
+    // With withWatchdogSnapshot(), the expiration is tracked here instead of using the WDT flag
+    bool expired = snapshotEnabled && watchdogMillis != 0 && (uint32_t)millis() - watchdogRefreshMillis >= watchdogMillis;
+
+    if (flags == 0) {
+        if (expired) {
+            // Recovered after the WIRQ, so the watchdog thread clears the stale WDT flag
+            watchdogClearWdtRequest = true;
+        }
+        refreshWDT();
+    }
+    else
+    if (expired && !watchdogResetArmed) {
+        // The snapshot needs more stack and I2C transactions than a timer callback should use
+        watchdogSnapshotFlags = flags;
+    }
+}
+
+void AB1805::watchdogThreadFunction() {
+    while(true) {
+        serviceWatchdogThread();
+        delay(WATCHDOG_THREAD_PERIOD_MS);
+    }
+}
+
+void AB1805::serviceWatchdogThread() {
+    if (watchdogClearWdtRequest) {
+        watchdogClearWdtRequest = false;
+        // So a stale WDT flag does not keep nIRQ asserted
+        clearRegisterBit(REG_STATUS, REG_STATUS_WDT);
+    }
+
+    uint8_t flags = watchdogSnapshotFlags;
+    if (flags != 0) {
+        watchdogSnapshotFlags = 0;
+        if (supervisorEnabled) {
+            // The loop thread may be hung, so save the miss counters before the reset
+            saveWatchdogSupervisor();
+        }
+        checkWatchdogInterrupt(flags);
+    }
+}
+
+bool AB1805::beginWatchdogBudget(uint8_t phase, uint32_t budgetMs) {
+    if (phase >= WATCHDOG_PHASE_MAX) {
+        return false;
+    }
+
+    if ((watchdogPhaseActive & (1 << phase)) == 0) {
+        watchdogPhaseStart[phase] = (uint32_t)millis();
+        watchdogPhaseActive |= (1 << phase);
+    }
+    watchdogPhaseBudget[phase] = budgetMs;
+
+    _log.trace("watchdog budget begin phase=%u budget=%lu", phase, (unsigned long)budgetMs);
+
+    if (watchdogMillis == 0 || watchdogTimerEnabled) {
+        // The timer services the watchdog during the phase
+        return true;
+    }
+
+    // The loop thread may be blocked for the whole phase, so increase the watchdog duration
+    uint32_t ms = budgetMs;
+    if (ms > (uint32_t)WATCHDOG_MAX_SECONDS * 1000) {
+        _log.info("watchdog budget %lu limited to %d seconds without withWatchdogRefreshTimer", (unsigned long)budgetMs, WATCHDOG_MAX_SECONDS);
+        ms = (uint32_t)WATCHDOG_MAX_SECONDS * 1000;
+    }
+    if (ms <= watchdogMillis) {
+        return true;
+    }
+    if (watchdogBudgetSavedMillis == 0) {
+        watchdogBudgetSavedMillis = watchdogMillis;
+    }
+    return writeWDTMillis(ms);
+}
+
+bool AB1805::endWatchdogBudget(uint8_t phase) {
+    if (phase >= WATCHDOG_PHASE_MAX || (watchdogPhaseActive & (1 << phase)) == 0) {
+        return true;
+    }
+    watchdogPhaseActive &= ~(1 << phase);
+
+    WatchdogPhaseStats &stats = watchdogPhaseStats[phase];
+    stats.lastMs = (uint32_t)millis() - watchdogPhaseStart[phase];
+    stats.count++;
+    if (stats.lastMs > stats.maxMs) {
+        stats.maxMs = stats.lastMs;
+    }
+    if (stats.lastMs > watchdogPhaseBudget[phase]) {
+        stats.overruns++;
+    }
+
+    _log.trace("watchdog budget end phase=%u duration=%lu", phase, (unsigned long)stats.lastMs);
+
+    if (watchdogPhaseActive != 0 || watchdogBudgetSavedMillis == 0) {
+        return true;
+    }
+
+    // Last phase ended, restore the watchdog duration
+    uint32_t ms = watchdogBudgetSavedMillis;
+    watchdogBudgetSavedMillis = 0;
+    if (watchdogMillis == 0) {
+        // Disabled during the phase
+        return true;
+    }
+    return writeWDTMillis(ms);
+}
+
+bool AB1805::isWatchdogBudgetActive() const {
+    uint8_t active = watchdogPhaseActive;
+
+    for(uint8_t phase = 0; active != 0; phase++, active >>= 1) {
+        if ((active & 1) != 0 && (uint32_t)millis() - watchdogPhaseStart[phase] < watchdogPhaseBudget[phase]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool AB1805::getWatchdogPhaseStats(uint8_t phase, WatchdogPhaseStats &stats) const {
+    if (phase >= WATCHDOG_PHASE_MAX) {
+        return false;
+    }
+    stats = watchdogPhaseStats[phase];
+    return true;
+}
+
+void AB1805::resetWatchdogPhaseStats() {
+    for(size_t ii = 0; ii < WATCHDOG_PHASE_MAX; ii++) {
+        watchdogPhaseStats[ii] = {};
+    }
+}
+
+// [static]
+uint8_t AB1805::watchdogRegisterValue(uint32_t ms, uint32_t &actualMs) {
+    // Watchdog clocks from finest to coarsest, period in 1/16 seconds
+    const uint8_t periods[4] = { 1, 4, 16, 64 };
+    const uint8_t wrbValues[4] = { REG_WDT_WRB_16_HZ, REG_WDT_WRB_4_HZ, REG_WDT_WRB_1_HZ, REG_WDT_WRB_1_4_HZ };
+
+    // Finest clock where the duration rounds to 31 ticks or fewer. BMB is 5 bits, 0 disables.
+    uint32_t sixteenths = (ms * 16 + 500) / 1000;
+    if (ms > 124000) {
+        sixteenths = 124 * 16;
+    }
+    size_t ii;
+    uint32_t ticks = 0;
+    for(ii = 0; ii < 4; ii++) {
+        ticks = (sixteenths + periods[ii] / 2) / periods[ii];
+        if (ticks <= 31) {
+            break;
+        }
+    }
+    if (ii == 4) {
+        ii = 3;
+        ticks = 31;
+    }
+    if (ticks < 1) {
+        ticks = 1;
+    }
+
+    actualMs = ticks * periods[ii] * 1000 / 16;
+
+    return (uint8_t)((ticks << 2) | wrbValues[ii]);
+}
+
+
+bool AB1805::addWatchdogClient(uint8_t id, uint32_t deadlineMs) {
+    if (id >= WATCHDOG_CLIENT_MAX || deadlineMs == 0) {
+        _log.error("addWatchdogClient invalid id %d", id);
+        return false;
+    }
+    watchdogClientHeartbeat[id] = (uint32_t)millis();
+    watchdogClientLate &= ~(1 << id);
+    watchdogClientDeadline[id] = deadlineMs;
+    return true;
+}
+
+void AB1805::removeWatchdogClient(uint8_t id) {
+    if (id < WATCHDOG_CLIENT_MAX) {
+        watchdogClientDeadline[id] = 0;
+        watchdogClientLate &= ~(1 << id);
+    }
+}
+
+void AB1805::watchdogHeartbeat(uint8_t id) {
+    if (id < WATCHDOG_CLIENT_MAX) {
+        watchdogClientHeartbeat[id] = (uint32_t)millis();
+        heartbeatIds = (heartbeatIds << 8) | id;
+    }
+}
+
+void AB1805::watchdogCheckpoint(uint16_t id) {
+    checkpointAddr = (uint32_t)(uintptr_t)__builtin_return_address(0);
+    checkpointId = id;
+}
+
+bool AB1805::getWatchdogSnapshot(WatchdogSnapshot &snapshot) const {
+    if (watchdogSnapshot.magic != WATCHDOG_SNAPSHOT_MAGIC) {
+        return false;
+    }
+    snapshot = watchdogSnapshot;
+    return true;
+}
+
+bool AB1805::loadWatchdogSnapshot() {
+    static const char *errorMsg = "failure in loadWatchdogSnapshot %d";
+
+    bool bResult = readRam(snapshotRamAddr, (uint8_t *)&watchdogSnapshot, sizeof(WatchdogSnapshot));
+    if (!bResult) {
+        _log.error(errorMsg, __LINE__);
+        watchdogSnapshot.magic = 0;
+        return false;
+    }
+    if (watchdogSnapshot.magic != WATCHDOG_SNAPSHOT_MAGIC) {
+        return true;
+    }
+
+    // Cleared so a later reset is not reported with this snapshot
+    uint32_t magic = 0;
+    bResult = writeRam(snapshotRamAddr, (const uint8_t *)&magic, sizeof(magic));
+    if (!bResult) {
+        _log.error(errorMsg, __LINE__);
+    }
+
+    if (wakeReason != WakeReason::WATCHDOG) {
+        watchdogSnapshot.magic = 0;
+        return bResult;
+    }
+
+    _log.info("watchdog snapshot uptime=%lu loopAge=%lu flags=0x%02x lateClients=0x%02x checkpoint=%u addr=0x%08lx heartbeats=0x%08lx freeMemory=%lu",
+        (unsigned long)watchdogSnapshot.uptimeMs, (unsigned long)watchdogSnapshot.loopAgeMs, watchdogSnapshot.flags, 
+        watchdogSnapshot.lateClients, watchdogSnapshot.checkpointId, (unsigned long)watchdogSnapshot.checkpointAddr, 
+        (unsigned long)watchdogSnapshot.heartbeatIds, (unsigned long)watchdogSnapshot.freeMemory);
+
+    return bResult;
+}
+
+bool AB1805::checkWatchdogInterrupt(uint8_t flags) {
+    static const char *errorMsg = "failure in checkWatchdogInterrupt %d";
+
+    if (watchdogResetArmed) {
+        return true;
+    }
+
+    WatchdogSnapshot snapshot = {};
+    snapshot.magic = WATCHDOG_SNAPSHOT_MAGIC;
+    snapshot.uptimeMs = (uint32_t)millis();
+    snapshot.freeMemory = System.freeMemory();
+    snapshot.checkpointAddr = checkpointAddr;
+    snapshot.checkpointId = checkpointId;
+    snapshot.loopAgeMs = (uint32_t)(millis() - loopMillis);
+    snapshot.heartbeatIds = heartbeatIds;
+    snapshot.lateClients = watchdogClientLate;
+    snapshot.flags = flags;
+
+    time_t rtcTime;
+    if (getRtcAsTime(rtcTime)) {
+        snapshot.rtcTime = (uint32_t)rtcTime;
+    }
+
+    bool bResult = writeRam(snapshotRamAddr, (const uint8_t *)&snapshot, sizeof(snapshot));
+    if (!bResult) {
+        _log.error(errorMsg, __LINE__);
+    }
+
+    // Reset after 1/16 second, whether or not the snapshot was saved
+    watchdogResetArmed = true;
+    return writeRegister(REG_WDT, REG_WDT_RESET | (1 << 2) | REG_WDT_WRB_16_HZ);
+}
+
+bool AB1805::checkWatchdogClients() {
+    bool healthy = updateWatchdogClients();
+    saveWatchdogSupervisor();
+    return healthy;
+}
+
+bool AB1805::updateWatchdogClients() {
+    bool healthy = true;
+    uint32_t now = (uint32_t)millis();
+
+    for(size_t id = 0; id < WATCHDOG_CLIENT_MAX; id++) {
+        if (watchdogClientDeadline[id] == 0) {
+            continue;
+        }
+        if (now - watchdogClientHeartbeat[id] <= watchdogClientDeadline[id]) {
+            watchdogClientLate &= ~(1 << id);
+            continue;
+        }
+
+        healthy = false;
+        if ((watchdogClientLate & (1 << id)) == 0) {
+            // First check since the deadline was missed
+            watchdogClientLate |= (1 << id);
+
+            // Atomic with the copy in saveWatchdogSupervisor(), which can run in another thread
+            ATOMIC_BLOCK() {
+                watchdogClientNewlyLate |= (1 << id);
+                if (supervisorState.misses[id] != 0xffff) {
+                    supervisorState.misses[id]++;
+                }
+                supervisorState.starvedClient = (uint8_t)(id + 1);
+                supervisorStateChanged = true;
+            }
+        }
+    }
+
+    if (healthy && supervisorState.starvedClient != 0) {
+        // Recovered before the watchdog reset, so a later reset is not blamed on this client
+        ATOMIC_BLOCK() {
+            supervisorState.starvedClient = 0;
+            supervisorStateChanged = true;
+        }
+    }
+
+    return healthy;
+}
+
+bool AB1805::saveWatchdogSupervisor() {
+    static const char *errorMsg = "failure in saveWatchdogSupervisor %d";
+
+    if (!supervisorStateChanged) {
+        return true;
+    }
+
+    // updateWatchdogClients() runs in the timer thread, so the state is copied and the flags are 
+    // cleared together
+    WatchdogSupervisorState state;
+    uint8_t newlyLate;
+    ATOMIC_BLOCK() {
+        state = supervisorState;
+        newlyLate = watchdogClientNewlyLate;
+        watchdogClientNewlyLate = 0;
+        supervisorStateChanged = false;
+    }
+
+    for(size_t id = 0; id < WATCHDOG_CLIENT_MAX; id++) {
+        if ((newlyLate & (1 << id)) != 0) {
+            _log.error("watchdog client %d missed deadline, not refreshing watchdog", (int)id);
+        }
+    }
+
+    // Saved now, as the watchdog may reset the device before there's another chance
+    bool bResult = writeRam(supervisorRamAddr, (const uint8_t *)&state, sizeof(WatchdogSupervisorState));
+    if (!bResult) {
+        _log.error(errorMsg, __LINE__);
+    }
+    return bResult;
+}
+
+bool AB1805::resetWatchdogClientMisses() {
+    memset(supervisorState.misses, 0, sizeof(supervisorState.misses));
+    supervisorState.starvedClient = 0;
+
+    return writeRam(supervisorRamAddr, (const uint8_t *)&supervisorState, sizeof(WatchdogSupervisorState));
+}
+
+bool AB1805::loadWatchdogSupervisor() {
+    static const char *errorMsg = "failure in loadWatchdogSupervisor %d";
+
+    bool bResult = readRam(supervisorRamAddr, (uint8_t *)&supervisorState, sizeof(WatchdogSupervisorState));
+    if (!bResult || supervisorState.magic != WATCHDOG_SUPERVISOR_MAGIC) {
+        memset(&supervisorState, 0, sizeof(WatchdogSupervisorState));
+        supervisorState.magic = WATCHDOG_SUPERVISOR_MAGIC;
+    }
+
+    watchdogStarvedClient = -1;
+    if (supervisorState.starvedClient != 0) {
+        if (wakeReason == WakeReason::WATCHDOG) {
+            watchdogStarvedClient = supervisorState.starvedClient - 1;
+            _log.info("watchdog reset, client %d starved the watchdog", watchdogStarvedClient);
+        }
+        supervisorState.starvedClient = 0;
+    }
+
+    // Saved even if unchanged to initialize the magic bytes and clear starvedClient
+    bResult = writeRam(supervisorRamAddr, (const uint8_t *)&supervisorState, sizeof(WatchdogSupervisorState));
+    if (!bResult) {
+        _log.error(errorMsg, __LINE__);
+    }
+    return bResult;
+}
+
+bool AB1805::setRtcFromSystem() {
+    if (Time.isValid()) {
+        return setRtcFromTime(Time.now());
+    }
+    else {
+        return false;
+    }
+}
+
+bool AB1805::setRtcFromSystemAligned(unsigned long maxWaitMs) {
+    static const char *errorMsg = "failure in setRtcFromSystemAligned %d";
+    uint8_t array[8];
+
+    if (!Time.isValid()) {
+        return false;
+    }
+
+    // Read the old time so the step can be removed from the calibration samples
+    uint8_t oldArray[TIME_BLOCK_SIZE];
+    unsigned long oldMillis = millis();
+    bool calibrationStep = calibrationEnabled && calibrationState.numSamples != 0 && readTimeBlock(oldArray);
+
+    // Can only write RTC registers when WRTC is 1. This is done before waiting for the
+    // second boundary so only the time write is done after it.
+    bool bResult = setRegisterBit(REG_CTRL_1, REG_CTRL_1_WRTC);
+    if (!bResult) {
+        _log.error(errorMsg, __LINE__);
+        return false;
+    }
+
+    // Measure the write latency with a same-length write of the current second, which is
+    // overwritten below
+    time_t start = Time.now();
+    array[0] = 0;
+    timeToRegisters(start, &array[1]);
+    unsigned long writeStart = micros();
+    bResult = writeRegisters(REG_HUNDREDTH, array, sizeof(array));
+    unsigned long writeUs = micros() - writeStart;
+    if (!bResult) {
+        _log.error(errorMsg, __LINE__);
+        return false;
+    }
+
+    // Wait for the system clock to change to the next second
+    time_t now;
+    unsigned long startMillis = millis();
+    do {
+        now = Time.now();
+    } while(now == start && millis() - startMillis < maxWaitMs);
+    unsigned long boundaryMicros = micros();
+    bool aligned = (now != start);
+
+    wire.lock();
+
+    uint64_t ms = (uint64_t)now * 1000;
+    if (aligned) {
+        // Time elapsed since the boundary plus the expected time until the write completes,
+        // rounded to the nearest hundredth
+        ms += ((micros() - boundaryMicros) + writeUs + 5000) / 10000 * 10;
+    }
+
+    array[0] = valueToBcd((int)(ms % 1000) / 10); // hundredths
+    timeToRegisters((time_t)(ms / 1000), &array[1]);
+
+    bResult = writeRegisters(REG_HUNDREDTH, array, sizeof(array), false);
+
+    // The cached clock must be reloaded from the new time
+    cachedClockValid = false;
+
+    if (bResult) {
+        if (calibrationStep) {
+            calibrationRtcStep((int64_t)ms - (int64_t)registersToMillis(oldArray) - (int64_t)(millis() - oldMillis));
+        }
+
+        // Clear the REG_CTRL_1_WRTC after setting the RTC.
+        // Aside from being a good thing to do, that's how we know we've set it.
+        clearRegisterBit(REG_CTRL_1, REG_CTRL_1_WRTC, false);
+    }
+    else {
+        _log.error(errorMsg, __LINE__);
+    }
+
+    wire.unlock();
+
+    _log.info("setRtcFromSystemAligned %s.%03d aligned=%d writeUs=%lu", 
+        Time.format((time_t)(ms / 1000), TIME_FORMAT_DEFAULT).c_str(), (int)(ms % 1000), aligned, writeUs);
+
+    return bResult;
+}
+
+bool AB1805::setRtcFromTime(time_t time, bool lock) {
+    uint8_t array[8];
+
+    _log.info("setRtcFromTime %s", Time.format(time, TIME_FORMAT_DEFAULT).c_str());
+
+    array[0] = 0x00; // hundredths
+    timeToRegisters(time, &array[1]);
+
+    return setRtcFromRegisters(array, lock);
+}
+
+bool AB1805::setRtcFromMillis(uint64_t ms, bool lock) {
+    uint8_t array[8];
+
+    _log.info("setRtcFromMillis %s.%03d", Time.format((time_t)(ms / 1000), TIME_FORMAT_DEFAULT).c_str(), (int)(ms % 1000));
+
+    array[0] = valueToBcd((int)(ms % 1000) / 10); // hundredths
+    timeToRegisters((time_t)(ms / 1000), &array[1]);
+
+    return setRtcFromRegisters(array, lock);
+}
+
+bool AB1805::setRtcFromTm(const struct tm *timeptr, bool lock) {
+    uint8_t array[8];
+
+    _log.info("setRtcAsTm %s", tmToString(timeptr).c_str());
+
+    array[0] = 0x00; // hundredths
+    tmToRegisters(timeptr, &array[1], true);
+
+    return setRtcFromRegisters(array, lock);
+}
+
+bool AB1805::setRtcFromRegisters(const uint8_t *array, bool lock) {
+    static const char *errorMsg = "failure in setRtcFromRegisters %d";
+
+    if (lock) {
+        wire.lock();
+    }
+
+    // Read the old time so the step can be removed from the calibration samples
+    uint8_t oldArray[TIME_BLOCK_SIZE];
+    unsigned long oldMillis = millis();
+    bool calibrationStep = calibrationEnabled && calibrationState.numSamples != 0 && readTimeBlock(oldArray, false);
+
+    // Can only write RTC registers when WRTC is 1
+    bool bResult = setRegisterBit(REG_CTRL_1, REG_CTRL_1_WRTC);
+    if (bResult) {
+        unsigned long writeMillis = millis();
+        bResult = writeRegisters(REG_HUNDREDTH, array, 8, false);
+
+        // The cached clock must be reloaded from the new time
+        cachedClockValid = false;
+
+        if (bResult) {
+            if (calibrationStep) {
+                calibrationRtcStep((int64_t)registersToMillis(array) - (int64_t)registersToMillis(oldArray) - (int64_t)(writeMillis - oldMillis));
+            }
+
+            // Clear the REG_CTRL_1_WRTC after setting the RTC.
+            // Aside from being a good thing to do, that's how we know we've set it.
+            clearRegisterBit(REG_CTRL_1, REG_CTRL_1_WRTC);
+        }
+        else {
+            _log.error(errorMsg, __LINE__);
+        }
+    }
+    else {
+        _log.error(errorMsg, __LINE__);
+    }
+
+    if (lock) {
+        wire.unlock();
+    }
+
+    return bResult;
+}
+
+bool AB1805::getRtcAsTime(time_t &time) {
+    uint8_t status;
+    return getRtcAsTime(time, status);
+}
+
+bool AB1805::getRtcAsTime(time_t &time, uint8_t &status) {
+    uint8_t array[TIME_BLOCK_SIZE];
+
+    bool bResult = readRtcRegisters(array, status);
+    if (bResult) {
+        time = registersToTime(&array[REG_SECOND]);
+
+        _log.trace("getRtcAsTime %ld", (long)time);
+    }
+    else {
+        time = 0;
+    }
+
+    return bResult;   
+}
+
+bool AB1805::getRtcAsMillis(uint64_t &ms) {
+    uint8_t status;
+    return getRtcAsMillis(ms, status);
+}
+
+bool AB1805::getRtcAsMillis(uint64_t &ms, uint8_t &status) {
+    uint8_t array[TIME_BLOCK_SIZE];
+
+    bool bResult = readRtcRegisters(array, status);
+    if (bResult) {
+        ms = registersToMillis(array);
+    }
+    else {
+        ms = 0;
+    }
+
+    return bResult;
+}
+
+bool AB1805::getRtcAsTimespec(struct timespec &ts) {
+    uint8_t array[TIME_BLOCK_SIZE];
+    uint8_t status;
+
+    bool bResult = readRtcRegisters(array, status);
+    if (bResult) {
+        ts.tv_sec = registersToTime(&array[REG_SECOND]);
+        ts.tv_nsec = bcdToValue(array[REG_HUNDREDTH]) * 10000000L;
+    }
+    else {
+        ts.tv_sec = 0;
+        ts.tv_nsec = 0;
+    }
+
+    return bResult;
+}
+
+bool AB1805::getCachedRtcAsMillis(uint64_t &ms) {
+    if (!cachedClockEnabled) {
+        return getRtcAsMillis(ms);
+    }
+
+    // Usually done from loop(), but checked here too so the error is bounded even if loop() is not running
+    if (cachedClockNeedsSync()) {
+        syncCachedClock();
+    }
+
+    bool valid;
+    ATOMIC_BLOCK() {
+        valid = cachedClockValid;
+        ms = cachedClockMs + (millis() - cachedClockMillis);
+    }
+    if (!valid) {
+        ms = 0;
+    }
+    return valid;
+}
+
+bool AB1805::cachedClockNeedsSync() const {
+    bool valid;
+    unsigned long elapsed;
+
+    ATOMIC_BLOCK() {
+        valid = cachedClockValid;
+        elapsed = millis() - cachedClockMillis;
+    }
+
+    // If the RTC is not set yet, or it was just set, check once per second
+    return valid ? (elapsed >= cachedClockResyncPeriod || getCachedClockErrorMs() > cachedClockMaxError) : (elapsed >= 1000);
+}
+
+bool AB1805::getCachedRtcAsTime(time_t &time) {
+    uint64_t ms;
+
+    bool bResult = getCachedRtcAsMillis(ms);
+    time = (time_t)(ms / 1000);
+
+    return bResult;
+}
+
+bool AB1805::syncCachedClock() {
+    uint64_t ms;
+
+    bool bResult = getRtcAsMillis(ms);
+    if (bResult) {
+        ATOMIC_BLOCK() {
+            cachedClockMs = ms;
+            cachedClockMillis = millis();
+            cachedClockValid = true;
+        }
+    }
+    else {
+        // cachedClockMillis is the time of the last attempt when not valid
+        ATOMIC_BLOCK() {
+            cachedClockValid = false;
+            cachedClockMillis = millis();
+        }
+    }
+    return bResult;
+}
+
+unsigned long AB1805::getCachedClockErrorMs() const {
+    // 10 ms for the resolution of REG_HUNDREDTH, plus the MCU clock drift since the last read
+    unsigned long elapsed = millis() - cachedClockMillis;
+    return 10 + (unsigned long)(((uint64_t)elapsed * cachedClockPpm) / 1000000);
+}
+
+bool AB1805::updateCalibration(time_t refTime, unsigned long refMillis) {
+    static const char *errorMsg = "failure in updateCalibration %d";
+    CalibrationState &cs = calibrationState;
+    uint8_t array[TIME_BLOCK_SIZE];
+
+    // WRTC is only checked for the first sample. It's set by resetConfig() but the counters 
+    // are still running, and the samples are lost along with the RTC RAM on power loss.
+    if (!readTimeBlock(array) || !isValidTimeBlock(array)) {
+        _log.error(errorMsg, __LINE__);
+        return false;
+    }
+    int64_t refMs = (int64_t)refTime * 1000 + (int64_t)(millis() - refMillis);
+    int64_t offsetMs = (int64_t)registersToMillis(array) - refMs;
+
+    if (cs.numSamples == 0 && ((array[REG_CTRL_1] & REG_CTRL_1_WRTC) != 0 || offsetMs > 86400000 || offsetMs < -86400000)) {
+        // RTC has not been set, the baseline is started at the next sync after it is set
+        return true;
+    }
+
+    if (cs.numSamples != 0) {
+        int64_t elapsed = refMs / 1000 - cs.baseTime;
+        int64_t correctedMs = offsetMs + cs.correctionMs;
+        const CalibrationSample &last = cs.samples[cs.numSamples - 1];
+
+        // Allow up to 500 ppm of drift. Anything larger means the RTC was changed without
+        // being tracked, or the reference time went backwards, so start over.
+        if (elapsed < (int64_t)last.elapsed || correctedMs > 5000 + elapsed / 2 || correctedMs < -5000 - elapsed / 2) {
+            _log.info("calibration samples discarded elapsed=%ld offset=%ld", (long)elapsed, (long)correctedMs);
+            cs.numSamples = 0;
+        }
+        else
+        if (elapsed - last.elapsed < CALIBRATION_MIN_INTERVAL) {
+            // Too close to the last sample to be useful
+            return true;
+        }
+        else {
+            if (cs.numSamples == CALIBRATION_MAX_SAMPLES) {
+                memmove(&cs.samples[0], &cs.samples[1], sizeof(CalibrationSample) * (CALIBRATION_MAX_SAMPLES - 1));
+                cs.numSamples--;
+            }
+            cs.samples[cs.numSamples].elapsed = (uint32_t)elapsed;
+            cs.samples[cs.numSamples].offsetMs = (int32_t)correctedMs;
+            cs.numSamples++;
+
+            _log.info("calibration sample elapsed=%ld offset=%ld", (long)elapsed, (long)correctedMs);
+        }
+    }
+
+    bool bResult = true;
+
+    if (cs.numSamples >= CALIBRATION_MIN_SAMPLES && cs.samples[cs.numSamples - 1].elapsed - cs.samples[0].elapsed >= calibrationMinSpan) {
+        // Least squares fit of offset vs. elapsed time. The slope in ms per second is ppm / 1000.
+        double meanX = 0, meanY = 0;
+        for(size_t ii = 0; ii < cs.numSamples; ii++) {
+            meanX += cs.samples[ii].elapsed;
+            meanY += cs.samples[ii].offsetMs;
+        }
+        meanX /= cs.numSamples;
+        meanY /= cs.numSamples;
+
+        double sxx = 0, sxy = 0;
+        for(size_t ii = 0; ii < cs.numSamples; ii++) {
+            double dx = cs.samples[ii].elapsed - meanX;
+            sxx += dx * dx;
+            sxy += dx * (cs.samples[ii].offsetMs - meanY);
+        }
+        float ppm = (float)(sxy / sxx * 1000.0);
+
+        if (ppm >= calibrationMinErrorPpm || ppm <= -calibrationMinErrorPpm) {
+            // A positive ppm means the RTC is fast so the adjustment is decreased
+            int adj = cs.adj - (int)lroundf(ppm / XT_CAL_PPM_PER_STEP);
+            adj = constrain(adj, -320, 127);
+
+            _log.info("calibration drift %.1f ppm, adj %d -> %d", ppm, cs.adj, adj);
+
+            bResult = setXtCalibration(adj);
+            if (bResult) {
+                // Samples from the old calibration no longer apply
+                cs.adj = (int16_t)adj;
+                cs.numSamples = 0;
+            }
+        }
+    }
+
+    if (cs.numSamples == 0) {
+        // Start a new set of samples with this one as the baseline
+        cs.baseTime = (uint32_t)(refMs / 1000);
+        cs.correctionMs = (int32_t)-offsetMs;
+        cs.samples[0].elapsed = 0;
+        cs.samples[0].offsetMs = 0;
+        cs.numSamples = 1;
+    }
+
+    if (!saveCalibration()) {
+        bResult = false;
+    }
+
+    return bResult;
+}
+
+bool AB1805::resetCalibration(bool clearAdjustment) {
+    bool bResult = true;
+
+    if (clearAdjustment) {
+        bResult = setXtCalibration(0);
+        if (bResult) {
+            calibrationState.adj = 0;
+        }
+    }
+    calibrationState.numSamples = 0;
+
+    if (calibrationEnabled && !saveCalibration()) {
+        bResult = false;
+    }
+    return bResult;
+}
+
+bool AB1805::setXtCalibration(int adj, bool lock) {
+    static const char *errorMsg = "failure in setXtCalibration %d";
+    uint8_t calXt, xtcal;
+
+    if (!xtCalibrationRegisters(adj, calXt, xtcal)) {
+        _log.error("setXtCalibration adj %d out of range", adj);
+        return false;
+    }
+
+    RegisterBatch batch(*this);
+    batch.write(REG_CAL_XT, calXt);
+    batch.mask(REG_OSC_STATUS, (uint8_t)~REG_OSC_STATUS_XTCAL, (uint8_t)(xtcal << REG_OSC_STATUS_XTCAL_SHIFT));
+
+    bool bResult = batch.commit(lock);
+    if (!bResult) {
+        _log.error(errorMsg, __LINE__);
+    }
+    return bResult;
+}
+
+// [static]
+bool AB1805::xtCalibrationRegisters(int adj, uint8_t &calXt, uint8_t &xtcal) {
+    bool cmdx = false;
+    int offsetx;
+
+    xtcal = 0;
+
+    if (adj < -320) {
+        // XT frequency too high to calibrate
+        return false;
+    }
+    else
+    if (adj < -256) {
+        xtcal = 3;
+        cmdx = true;
+        offsetx = (adj + 192) / 2;
+    }
+    else
+    if (adj < -192) {
+        xtcal = 3;
+        offsetx = adj + 192;
+    }
+    else
+    if (adj < -128) {
+        xtcal = 2;
+        offsetx = adj + 128;
+    }
+    else
+    if (adj < -64) {
+        xtcal = 1;
+        offsetx = adj + 64;
+    }
+    else
+    if (adj < 64) {
+        offsetx = adj;
+    }
+    else
+    if (adj < 128) {
+        cmdx = true;
+        offsetx = adj / 2;
+    }
+    else {
+        // XT frequency too low to calibrate
+        return false;
+    }
+
+    calXt = (cmdx ? REG_CAL_XT_CMDX : 0) | ((uint8_t)offsetx & REG_CAL_XT_OFFSETX_MASK);
+    return true;
+}
+
+bool AB1805::loadCalibration() {
+    bool bResult = readRam(calibrationRamAddr, (uint8_t *)&calibrationState, sizeof(CalibrationState));
+    if (!bResult || calibrationState.magic != CALIBRATION_MAGIC || calibrationState.numSamples > CALIBRATION_MAX_SAMPLES) {
+        // RTC RAM is lost on power loss, as is REG_CAL_XT, so start over
+        memset(&calibrationState, 0, sizeof(CalibrationState));
+        calibrationState.magic = CALIBRATION_MAGIC;
+    }
+
+    // Apply the adjustment in case the registers were reset
+    if (!setXtCalibration(calibrationState.adj)) {
+        bResult = false;
+    }
+
+    _log.info("calibration adj=%d numSamples=%d", calibrationState.adj, calibrationState.numSamples);
+
+    return bResult;
+}
+
+bool AB1805::saveCalibration() {
+    return writeRam(calibrationRamAddr, (const uint8_t *)&calibrationState, sizeof(CalibrationState));
+}
+
+void AB1805::calibrationRtcStep(int64_t stepMs) {
+    // The offset after the step must be corrected to continue the line from before the step
+    calibrationState.correctionMs -= (int32_t)stepMs;
+    saveCalibration();
+}
+
+bool AB1805::getRtcAsTm(struct tm *timeptr) {
+    uint8_t status;
+    return getRtcAsTm(timeptr, status);
+}
+
+bool AB1805::getRtcAsTm(struct tm *timeptr, uint8_t &status) {
+    uint8_t array[TIME_BLOCK_SIZE];
+
+    bool bResult = readRtcRegisters(array, status);
+    if (bResult) {
+        registersToTm(&array[REG_SECOND], timeptr, true);
+
+        _log.info("getRtcAsTm %s", tmToString(timeptr).c_str());
+    }
+    else {
+        memset(timeptr, 0, sizeof(*timeptr));
+    }
+
+    return bResult;
+}
+
+bool AB1805::readRtcRegisters(uint8_t *array, uint8_t &status, bool lock) {
+    bool bResult = readTimeBlock(array, lock);
+    if (bResult) {
+        status = array[REG_STATUS];
+
+        // If we've set the time in the RTC, then the WTC bit will be 0.
+        // On power-up from cold, it's 1
+        if ((array[REG_CTRL_1] & REG_CTRL_1_WRTC) != 0) {
+            bResult = false;
+        }
+        else
+        if (!isValidTimeBlock(array)) {
+            _log.error("invalid time registers %02x %02x %02x %02x %02x %02x %02x %02x", 
+                array[0], array[1], array[2], array[3], array[4], array[5], array[6], array[7]);
+            bResult = false;
+        }
+    }
+    else {
+        status = 0;
+    }
+    return bResult;
+}
+
+bool AB1805::readTimeBlock(uint8_t *array, bool lock) {
+    // REG_HUNDREDTH (0x00) through REG_CTRL_1 (0x10) are contiguous, so the time, alarm, 
+    // status, and WRTC bit can be read in a single transaction. Reading REG_STATUS does
+    // not clear the flags unless ARST is set in REG_CTRL_1, which this library does not do.
+    return readRegisters(REG_HUNDREDTH, array, TIME_BLOCK_SIZE, lock);
+}
+
+
+#if 0
+bool AB1805::testEN() {
+    _log.info("testEN()");
+
+    // Test function to drive EN low (device power off) by setting PSW/nIRQ2 high
+    // Note: Only way to recover from this is to depower the AB1805!
+
+    // Control PWR/nIRQ2 using OUTB
+    maskRegister(REG_CTRL_2, ~REG_CTRL_2_OUT2S_MASK, REG_CTRL_2_OUT2S_OUTB);
+
+    // In order to change OUTB, you need to clear LKO2. This is done by setting
+    // Oscillator Status to 0. This will also clear the OF (oscillator failure)
+    // but, but this is OK.
+    writeRegister(REG_OSC_STATUS, 0x00);
+
+    // Set PWR2 to 0 (default 1), this allows PWR/nIRQ2 to be normal open-drain 
+    // Set OUTB to 1 (default 0), this should set EN low via the N-channel MOSFET
+    maskRegister(REG_CTRL_1, ~REG_CTRL_1_PWR2, REG_CTRL_1_OUTB);
+
+    return true;
+}  
+#endif
+
+bool AB1805::interruptAtTime(time_t time) {
+    struct tm tmstruct;
+    gmtime_r(&time, &tmstruct);
+    return interruptAtTm(&tmstruct);
+}
+
+bool AB1805::interruptAtTm(struct tm *timeptr) {
+    return repeatingInterrupt(timeptr, REG_TIMER_CTRL_RPT_DATE);
+}
+
+bool AB1805::interruptAtMillis(uint64_t ms) {
+    // Round to the nearest hundredth, which can carry into the next second
+    uint64_t hundredths = (ms + 5) / 10;
+    time_t time = (time_t)(hundredths / 100);
+
+    struct tm tmstruct;
+    gmtime_r(&time, &tmstruct);
+    return repeatingInterrupt(&tmstruct, REG_TIMER_CTRL_RPT_DATE, valueToBcd((int)(hundredths % 100)));
+}
+
+bool AB1805::repeatingInterruptSubSecond(SubSecondRepeat rpt, uint16_t offsetMs) {
+    return repeatingInterrupt(NULL, REG_TIMER_CTRL_RPT_HUN, hundredthsAlarmValue(rpt, offsetMs));
+}
+
+bool AB1805::repeatingInterrupt(struct tm *timeptr, uint8_t rptValue, uint8_t hundredths) {
+    static const char *errorMsg = "failure in repeatingInterrupt %d";
+    bool bResult;
+
+    // Disable watchdog
+    bResult = setWDT(0);
+    if (!bResult) {
+        _log.error(errorMsg, __LINE__);
+        return false;
+    }
+
+    RegisterBatch batch(*this);
+    addRepeatingInterrupt(batch, timeptr, rptValue, hundredths);
+
+    bResult = batch.commit();
+    if (!bResult) {
+        _log.error(errorMsg, __LINE__);
+        return false;
+    }
+
+#if 0
+    {
+        // TESTING
+        uint8_t array2[7];
+
+        bResult = readRegisters(REG_HUNDREDTH_ALARM, array2, sizeof(array2));
+        _log.info("alarm (first) current (second)");
         _log.dump(array2, sizeof(array2));
         _log.print("\n");
 
-        uint8_t array3[8];
-        bResult = readRegisters(REG_HUNDREDTH, array3, sizeof(array3));
-        _log.dump(array3, sizeof(array3));
-        _log.print("\n");
+        uint8_t array3[8];
+        bResult = readRegisters(REG_HUNDREDTH, array3, sizeof(array3));
+        _log.dump(array3, sizeof(array3));
+        _log.print("\n");
+    }
+#endif
+    
+    return true;
+}
+
+void AB1805::addRepeatingInterrupt(RegisterBatch &batch, const struct tm *timeptr, uint8_t rptValue, uint8_t hundredths) {
+    // Set alarm registers
+    uint8_t array[7];
+
+    array[0] = hundredths;
+    if (timeptr) {
+        tmToRegisters(timeptr, &array[1], false);
+        batch.writeBlock(REG_HUNDREDTH_ALARM, array, sizeof(array));
+    }
+    else {
+        batch.write(REG_HUNDREDTH_ALARM, hundredths);
+    }
+
+    // Clear any existing alarm (ALM) interrupt in status register
+    // (REG_STATUS immediately follows the alarm registers, so this is part of the same write)
+    batch.clear(REG_STATUS, REG_STATUS_ALM);
+
+    // Set FOUT/nIRQ control in OUT1S in Control2 for 
+    // "nAIRQ if AIE is set, else OUT"
+    batch.mask(REG_CTRL_2, ~REG_CTRL_2_OUT1S_MASK, REG_CTRL_2_OUT1S_nAIRQ);
+
+    // Enable alarm interrupt (AIE) in interrupt mask register
+    batch.set(REG_INT_MASK, REG_INT_MASK_AIE);
+
+    // Enable alarm
+    batch.mask(REG_TIMER_CTRL, ~REG_TIMER_CTRL_RPT_MASK, rptValue & REG_TIMER_CTRL_RPT_MASK);
+}
+
+bool AB1805::setAlarmTimer(uint8_t id, time_t deadline, uint32_t periodSecs, uint32_t slackSecs) {
+    AlarmTimerQueue &q = alarmTimerQueue;
+
+    if (periodSecs > ALARM_TIMER_MAX_PERIOD) {
+        periodSecs = ALARM_TIMER_MAX_PERIOD;
+    }
+
+    int index = findAlarmTimer(id);
+    if (index < 0) {
+        if (q.numTimers >= ALARM_TIMER_MAX) {
+            _log.error("setAlarmTimer too many timers");
+            return false;
+        }
+        index = q.numTimers++;
+    }
+
+    uint32_t oldDeadline = q.timers[index].deadline;
+    q.timers[index].deadline = (uint32_t)deadline;
+    q.timers[index].periodAndId = (periodSecs << 8) | id;
+    q.timers[index].slack = slackSecs;
+
+    if (index == q.numTimers - 1 || (uint32_t)deadline < oldDeadline) {
+        alarmTimerSiftUp(index);
+    }
+    else {
+        alarmTimerSiftDown(index);
+    }
+
+    return updateAlarmTimers();
+}
+
+bool AB1805::setAlarmTimerIn(uint8_t id, uint32_t delaySecs, uint32_t periodSecs, uint32_t slackSecs) {
+    if (!Time.isValid()) {
+        return false;
+    }
+    return setAlarmTimer(id, Time.now() + delaySecs, periodSecs, slackSecs);
+}
+
+bool AB1805::cancelAlarmTimer(uint8_t id) {
+    int index = findAlarmTimer(id);
+    if (index < 0) {
+        return true;
+    }
+    removeAlarmTimerAt(index);
+
+    return updateAlarmTimers();
+}
+
+bool AB1805::getNextAlarmTimer(time_t &deadline, uint8_t &id) const {
+    if (alarmTimerQueue.numTimers == 0) {
+        return false;
+    }
+    deadline = alarmTimerQueue.timers[0].deadline;
+    id = (uint8_t)alarmTimerQueue.timers[0].periodAndId;
+    return true;
+}
+
+bool AB1805::getNextAlarmTimerWake(time_t &wakeTime) const {
+    const AlarmTimerQueue &q = alarmTimerQueue;
+    if (q.numTimers == 0) {
+        return false;
+    }
+
+    // The heap is ordered by deadline, not deadline + slack, so check all of the timers.
+    // Waking at the earliest end of a window runs every timer whose window has started,
+    // which gives the fewest wakes for the set of windows.
+    uint32_t wake = 0xffffffff;
+    for(size_t ii = 0; ii < q.numTimers; ii++) {
+        uint32_t end = q.timers[ii].deadline + q.timers[ii].slack;
+        if (end < q.timers[ii].deadline) {
+            end = 0xffffffff;
+        }
+        if (end < wake) {
+            wake = end;
+        }
+    }
+    wakeTime = (time_t)wake;
+    return true;
+}
+
+float AB1805::getAlarmTimerDutyCycle() const {
+    const AlarmTimerStats &stats = alarmTimerQueue.stats;
+    if (!Time.isValid() || stats.startTime == 0 || (uint32_t)Time.now() <= stats.startTime) {
+        return 1.0;
+    }
+
+    // Include the time awake since the stats were last saved
+    float awakeSecs = (float)(stats.awakeMs + (millis() - alarmTimerAwakeMillis)) / 1000.0;
+    float dutyCycle = awakeSecs / (float)((uint32_t)Time.now() - stats.startTime);
+    return (dutyCycle < 1.0) ? dutyCycle : 1.0;
+}
+
+bool AB1805::resetAlarmTimerStats() {
+    AlarmTimerStats &stats = alarmTimerQueue.stats;
+
+    memset(&stats, 0, sizeof(AlarmTimerStats));
+    if (Time.isValid()) {
+        stats.startTime = (uint32_t)Time.now();
+    }
+    alarmTimerAwakeMillis = millis();
+
+    return updateAlarmTimers();
+}
+
+bool AB1805::serviceAlarmTimers() {
+    AlarmTimerQueue &q = alarmTimerQueue;
+
+    if (!Time.isValid()) {
+        return false;
+    }
+    uint32_t now = (uint32_t)Time.now();
+
+    // Handlers can set or cancel timers. The queue is saved and the alarm is set once at the end.
+    alarmTimersServicing = true;
+
+    uint32_t fired = 0;
+    while(q.numTimers != 0 && q.timers[0].deadline <= now) {
+        uint8_t id = (uint8_t)q.timers[0].periodAndId;
+        uint32_t period = q.timers[0].periodAndId >> 8;
+
+        if (period != 0) {
+            // Skip any periods that were missed, such as during deepPowerDown()
+            q.timers[0].deadline += ((now - q.timers[0].deadline) / period + 1) * period;
+            alarmTimerSiftDown(0);
+        }
+        else {
+            removeAlarmTimerAt(0);
+        }
+
+        _log.trace("alarm timer %d expired", id);
+        fired++;
+
+        if (alarmTimerHandler) {
+            alarmTimerHandler(id);
+        }
+    }
+
+    alarmTimersServicing = false;
+
+    // All of the timers run together count as one wake, but only if the RTC alarm woke the device. 
+    // Timers run by AB1805::loop() while already awake are not a wake.
+    if (fired != 0 && alarmTimerWakePending) {
+        q.stats.wakes++;
+        q.stats.timersFired += fired;
+    }
+    alarmTimerWakePending = false;
+
+    return updateAlarmTimers();
+}
+
+// Parses one field of a cron-style schedule, setting a bit in mask for each value.
+// p is advanced past the field.
+static bool parseScheduleField(const char *&p, int minValue, int maxValue, uint64_t &mask) {
+    mask = 0;
+
+    while(*p == ' ') {
+        p++;
+    }
+    if (*p == 0) {
+        return false;
+    }
+
+    while(true) {
+        int first, last, step = 1;
+        char *end;
+
+        if (*p == '*') {
+            first = minValue;
+            last = maxValue;
+            p++;
+        }
+        else {
+            first = last = (int) strtol(p, &end, 10);
+            if (end == p) {
+                return false;
+            }
+            p = end;
+            if (*p == '-') {
+                p++;
+                last = (int) strtol(p, &end, 10);
+                if (end == p) {
+                    return false;
+                }
+                p = end;
+            }
+        }
+        if (*p == '/') {
+            p++;
+            step = (int) strtol(p, &end, 10);
+            if (end == p || step < 1) {
+                return false;
+            }
+            p = end;
+            if (first == last) {
+                // "a/n" is from a to the maximum value
+                last = maxValue;
+            }
+        }
+        if (first < minValue || last > maxValue || first > last) {
+            return false;
+        }
+        for(int value = first; value <= last; value += step) {
+            mask |= (1ULL << value);
+        }
+
+        if (*p != ',') {
+            break;
+        }
+        p++;
+    }
+
+    return (*p == ' ' || *p == 0);
+}
+
+// [static]
+bool AB1805::parseSchedule(const char *spec, Schedule &schedule) {
+    // Count the fields to find out if there's a second field
+    size_t numFields = 0;
+    for(const char *p = spec; *p; p++) {
+        if (*p != ' ' && (p == spec || p[-1] == ' ')) {
+            numFields++;
+        }
+    }
+    if (numFields != 5 && numFields != 6) {
+        return false;
+    }
+
+    const char *p = spec;
+    uint64_t second = 1, minutes, hours, days, months, weekdays;
+
+    if (numFields == 6) {
+        if (!parseScheduleField(p, 0, 59, second) || (second & (second - 1)) != 0) {
+            // Only one second is supported by the alarm
+            return false;
+        }
+    }
+    if (!parseScheduleField(p, 0, 59, minutes) ||
+        !parseScheduleField(p, 0, 23, hours) ||
+        !parseScheduleField(p, 1, 31, days) ||
+        !parseScheduleField(p, 1, 12, months) ||
+        !parseScheduleField(p, 0, 7, weekdays)) {
+        return false;
+    }
+
+    schedule.minutes = minutes;
+    schedule.hours = (uint32_t)hours;
+    schedule.days = (uint32_t)days;
+    schedule.months = (uint16_t)(months >> 1);                                              // 1 - 12 to 0 - 11
+    schedule.weekdays = (uint8_t)((weekdays | (weekdays >> 7)) & SCHEDULE_ALL_WEEKDAYS);    // 7 is also Sunday
+    schedule.second = 0;
+    while(second > 1) {
+        second >>= 1;
+        schedule.second++;
+    }
+
+    return true;
+}
+
+// Returns true if the month and day of timeptr match a schedule
+static bool scheduleDayMatches(const AB1805::Schedule &schedule, const struct tm *timeptr) {
+    if ((schedule.months & (1U << timeptr->tm_mon)) == 0) {
+        return false;
+    }
+
+    bool dayMatch = (schedule.days & (1UL << timeptr->tm_mday)) != 0;
+    bool weekdayMatch = (schedule.weekdays & (1U << timeptr->tm_wday)) != 0;
+
+    if (schedule.days != AB1805::SCHEDULE_ALL_DAYS && schedule.weekdays != AB1805::SCHEDULE_ALL_WEEKDAYS) {
+        // Both restricted, cron matches either one
+        return dayMatch || weekdayMatch;
+    }
+    return dayMatch && weekdayMatch;
+}
+
+// [static]
+bool AB1805::scheduleMatches(const Schedule &schedule, const struct tm *timeptr) {
+    return timeptr->tm_sec == schedule.second &&
+        (schedule.minutes & (1ULL << timeptr->tm_min)) != 0 &&
+        (schedule.hours & (1UL << timeptr->tm_hour)) != 0 &&
+        scheduleDayMatches(schedule, timeptr);
+}
+
+// [static]
+time_t AB1805::nextScheduleTime(const Schedule &schedule, time_t after) {
+    // Start at the scheduled second of the minute after, or the same minute if it's still to come
+    time_t time = after - (after % 60) + schedule.second;
+    if (time <= after) {
+        time += 60;
+    }
+    time_t limit = after + 5 * 366 * 86400;
+
+    // time is always at the scheduled second. Skip ahead by the largest unit that doesn't match,
+    // so this takes at most one iteration per day, plus 24 for the hour and 60 for the minute.
+    while(time < limit) {
+        struct tm tmstruct;
+        gmtime_r(&time, &tmstruct);
+
+        if (!scheduleDayMatches(schedule, &tmstruct)) {
+            time += (23 - tmstruct.tm_hour) * 3600 + (59 - tmstruct.tm_min) * 60 + 60;
+        }
+        else
+        if ((schedule.hours & (1UL << tmstruct.tm_hour)) == 0) {
+            time += (59 - tmstruct.tm_min) * 60 + 60;
+        }
+        else
+        if ((schedule.minutes & (1ULL << tmstruct.tm_min)) == 0) {
+            time += 60;
+        }
+        else {
+            return time;
+        }
+    }
+    return 0;
+}
+
+// [static]
+uint8_t AB1805::scheduleRepeatMode(const Schedule &schedule) {
+    // Returns true if exactly one bit is set
+    auto single = [](uint64_t mask) { return mask != 0 && (mask & (mask - 1)) == 0; };
+
+    bool allMinutes = (schedule.minutes == SCHEDULE_ALL_MINUTES);
+    bool allHours = (schedule.hours == SCHEDULE_ALL_HOURS);
+    bool allDays = (schedule.days == SCHEDULE_ALL_DAYS);
+    bool allMonths = (schedule.months == SCHEDULE_ALL_MONTHS);
+    bool allWeekdays = (schedule.weekdays == SCHEDULE_ALL_WEEKDAYS);
+
+    if (allMinutes && allHours && allDays && allMonths && allWeekdays) {
+        return REG_TIMER_CTRL_RPT_SEC;
+    }
+    if (!single(schedule.minutes)) {
+        return REG_TIMER_CTRL_RPT_DIS;
+    }
+    if (allHours && allDays && allMonths && allWeekdays) {
+        return REG_TIMER_CTRL_RPT_MIN;
+    }
+    if (!single(schedule.hours)) {
+        return REG_TIMER_CTRL_RPT_DIS;
+    }
+    if (allDays && allMonths && allWeekdays) {
+        return REG_TIMER_CTRL_RPT_HOUR;
+    }
+    if (allDays && allMonths && single(schedule.weekdays)) {
+        return REG_TIMER_CTRL_RPT_WKDY;
+    }
+    if (single(schedule.days) && allWeekdays) {
+        if (allMonths) {
+            return REG_TIMER_CTRL_RPT_DATE;
+        }
+        if (single(schedule.months)) {
+            return REG_TIMER_CTRL_RPT_MON;
+        }
+    }
+    return REG_TIMER_CTRL_RPT_DIS;
+}
+
+bool AB1805::setSchedule(const char *spec, ScheduleHandler handler) {
+    Schedule sched;
+    if (!parseSchedule(spec, sched)) {
+        _log.error("invalid schedule %s", spec);
+        return false;
     }
-#endif
+    return setSchedule(sched, handler);
+}
 
-    // Set FOUT/nIRQ control in OUT1S in Control2 for 
-    // "nAIRQ if AIE is set, else OUT"
-    bResult = maskRegister(REG_CTRL_2, ~REG_CTRL_2_OUT1S_MASK, REG_CTRL_2_OUT1S_nAIRQ);
+bool AB1805::setSchedule(const Schedule &schedule, ScheduleHandler handler) {
+    if (alarmTimersEnabled) {
+        _log.error("setSchedule can't be used with withAlarmTimers");
+        return false;
+    }
+    if (!Time.isValid()) {
+        return false;
+    }
+
+    this->schedule = schedule;
+    scheduleHandler = handler;
+    scheduleRpt = scheduleRepeatMode(schedule);
+    scheduleNext = nextScheduleTime(schedule, Time.now());
+    if (scheduleNext == 0) {
+        _log.error("schedule never matches");
+        scheduleEnabled = false;
+        return false;
+    }
+    scheduleLast = 0;
+    scheduleEnabled = true;
+
+    return armSchedule();
+}
+
+bool AB1805::clearSchedule() {
+    if (!scheduleEnabled) {
+        return true;
+    }
+    scheduleEnabled = false;
+    scheduleNext = 0;
+
+    return clearRepeatingInterrupt();
+}
+
+bool AB1805::serviceSchedule() {
+    if (!scheduleEnabled || !Time.isValid()) {
+        return false;
+    }
+    time_t now = Time.now();
+
+    if (now < scheduleNext) {
+        if ((scheduleLast != 0 && now <= scheduleLast + SCHEDULE_ALARM_TOLERANCE_SECS) || scheduleNext - now <= SCHEDULE_ALARM_TOLERANCE_SECS) {
+            // The RTC is set in whole seconds, so it's up to a second behind the system clock. This is the
+            // ALM for the match the loop() poll already ran, or an early ALM for the next match, which the 
+            // poll will run.
+            return true;
+        }
+
+        // The alarm went off at a time that doesn't match, such as after the system clock was changed
+        scheduleFilteredWakes++;
+        _log.trace("schedule alarm filtered");
+        return armSchedule();
+    }
+
+    time_t scheduled = scheduleNext;
+    scheduleLast = scheduled;
+    scheduleNext = nextScheduleTime(schedule, now);
+
+    // The hardware repeats by itself if the repeat mode matches the schedule exactly
+    bool bResult = true;
+    if (scheduleNext == 0) {
+        scheduleEnabled = false;
+    }
+    else
+    if (scheduleRpt == REG_TIMER_CTRL_RPT_DIS) {
+        bResult = armSchedule();
+    }
+
+    if (scheduleHandler) {
+        scheduleHandler(scheduled);
+    }
+
+    return bResult;
+}
+
+bool AB1805::armSchedule() {
+    static const char *errorMsg = "failure in armSchedule %d";
+
+    uint8_t rpt = scheduleRpt;
+    if (rpt == REG_TIMER_CTRL_RPT_DIS) {
+        // Use the shortest repeat period that is longer than the time until scheduleNext,
+        // so the next alarm is at scheduleNext
+        time_t delta = scheduleNext - Time.now();
+        rpt = (delta < 60) ? REG_TIMER_CTRL_RPT_SEC :
+            (delta < 3600) ? REG_TIMER_CTRL_RPT_MIN :
+            (delta < 86400) ? REG_TIMER_CTRL_RPT_HOUR :
+            (delta < 7 * 86400) ? REG_TIMER_CTRL_RPT_WKDY : REG_TIMER_CTRL_RPT_MON;
+    }
+
+    struct tm tmstruct;
+    gmtime_r(&scheduleNext, &tmstruct);
+
+    _log.trace("schedule next %ld rpt=0x%02x", (long)scheduleNext, rpt);
+
+    RegisterBatch batch(*this);
+    addRepeatingInterrupt(batch, &tmstruct, rpt);
+
+    bool bResult = batch.commit();
+    if (!bResult) {
+        _log.error(errorMsg, __LINE__);
+    }
+    return bResult;
+}
+
+bool AB1805::loadAlarmTimers() {
+    AlarmTimerQueue &q = alarmTimerQueue;
+
+    // Only the header and the used timers are saved, so only they are read
+    bool bResult = readRam(alarmTimerRamAddr, (uint8_t *)&q, offsetof(AlarmTimerQueue, timers));
+    if (bResult && q.magic == ALARM_TIMER_MAGIC && q.numTimers <= ALARM_TIMER_MAX) {
+        bResult = readRam(alarmTimerRamAddr + offsetof(AlarmTimerQueue, timers), (uint8_t *)q.timers, q.numTimers * sizeof(AlarmTimer));
+    }
+    else {
+        memset(&q, 0, sizeof(AlarmTimerQueue));
+        q.magic = ALARM_TIMER_MAGIC;
+    }
+
+    _log.info("alarm timers numTimers=%d", q.numTimers);
+
+    // Set the hardware alarm even if it appears to be set already, as the registers may have been reset
+    alarmTimerArmed = 0;
+    if (q.numTimers != 0) {
+        bResult = updateAlarmTimers();
+    }
+
+    return bResult;
+}
+
+bool AB1805::updateAlarmTimers() {
+    static const char *errorMsg = "failure in updateAlarmTimers %d";
+    AlarmTimerQueue &q = alarmTimerQueue;
+
+    if (alarmTimersServicing) {
+        return true;
+    }
+
+    if (q.stats.startTime == 0 && Time.isValid()) {
+        q.stats.startTime = (uint32_t)Time.now();
+        alarmTimerAwakeMillis = millis();
+    }
+    if (q.stats.startTime != 0) {
+        unsigned long now = millis();
+        q.stats.awakeMs += now - alarmTimerAwakeMillis;
+        alarmTimerAwakeMillis = now;
+    }
+
+    bool bResult = writeRam(alarmTimerRamAddr, (const uint8_t *)&q, offsetof(AlarmTimerQueue, timers) + q.numTimers * sizeof(AlarmTimer));
+    if (!bResult) {
+        _log.error(errorMsg, __LINE__);
+    }
+
+    if (q.numTimers == 0) {
+        if (alarmTimerArmed != 0) {
+            if (clearRepeatingInterrupt()) {
+                alarmTimerArmed = 0;
+            }
+            else {
+                bResult = false;
+            }
+        }
+    }
+    else {
+        time_t wakeTime;
+        getNextAlarmTimerWake(wakeTime);
+        if ((uint32_t)wakeTime != alarmTimerArmed) {
+            struct tm tmstruct;
+            gmtime_r(&wakeTime, &tmstruct);
+
+            // Match month, date, and time (once per year) so wakes more than a month away don't alarm early
+            RegisterBatch batch(*this);
+            addRepeatingInterrupt(batch, &tmstruct, REG_TIMER_CTRL_RPT_MON);
+            if (batch.commit()) {
+                alarmTimerArmed = (uint32_t)wakeTime;
+            }
+            else {
+                _log.error(errorMsg, __LINE__);
+                bResult = false;
+            }
+        }
+    }
+
+    return bResult;
+}
+
+int AB1805::findAlarmTimer(uint8_t id) const {
+    for(size_t ii = 0; ii < alarmTimerQueue.numTimers; ii++) {
+        if ((uint8_t)alarmTimerQueue.timers[ii].periodAndId == id) {
+            return (int)ii;
+        }
+    }
+    return -1;
+}
+
+void AB1805::removeAlarmTimerAt(size_t index) {
+    AlarmTimerQueue &q = alarmTimerQueue;
+
+    q.numTimers--;
+    if (index < q.numTimers) {
+        // Move the last timer into the hole, then restore the heap order
+        uint32_t oldDeadline = q.timers[index].deadline;
+        q.timers[index] = q.timers[q.numTimers];
+        if (q.timers[index].deadline < oldDeadline) {
+            alarmTimerSiftUp(index);
+        }
+        else {
+            alarmTimerSiftDown(index);
+        }
+    }
+}
+
+void AB1805::alarmTimerSiftUp(size_t index) {
+    AlarmTimer *timers = alarmTimerQueue.timers;
+
+    while(index > 0) {
+        size_t parent = (index - 1) / 2;
+        if (timers[parent].deadline <= timers[index].deadline) {
+            break;
+        }
+        AlarmTimer tmp = timers[parent];
+        timers[parent] = timers[index];
+        timers[index] = tmp;
+        index = parent;
+    }
+}
+
+void AB1805::alarmTimerSiftDown(size_t index) {
+    AlarmTimer *timers = alarmTimerQueue.timers;
+    size_t numTimers = alarmTimerQueue.numTimers;
+
+    while(true) {
+        size_t smallest = index;
+        size_t left = 2 * index + 1;
+        size_t right = left + 1;
+        if (left < numTimers && timers[left].deadline < timers[smallest].deadline) {
+            smallest = left;
+        }
+        if (right < numTimers && timers[right].deadline < timers[smallest].deadline) {
+            smallest = right;
+        }
+        if (smallest == index) {
+            break;
+        }
+        AlarmTimer tmp = timers[smallest];
+        timers[smallest] = timers[index];
+        timers[index] = tmp;
+        index = smallest;
+    }
+}
+
+bool AB1805::clearRepeatingInterrupt() {
+    static const char *errorMsg = "failure in clearRepeatingInterrupt %d";
+    bool bResult;
+
+    RegisterBatch batch(*this);
+
+    // Set FOUT/nIRQ control in Control2 to the default value
+    batch.mask(REG_CTRL_2, ~REG_CTRL_2_OUT1S_MASK, REG_CTRL_2_OUT1S_nIRQ);
+
+    // Disable alarm interrupt (AIE) in interrupt mask register
+    batch.clear(REG_INT_MASK, REG_INT_MASK_AIE);
+
+    // Disable alarm
+    batch.mask(REG_TIMER_CTRL, ~REG_TIMER_CTRL_RPT_MASK, REG_TIMER_CTRL_RPT_DIS);
+
+    bResult = batch.commit();
     if (!bResult) {
         _log.error(errorMsg, __LINE__);
         return false;
     }
 
-    // Enable alarm interrupt (AIE) in interrupt mask register
-    bResult = setRegisterBit(REG_INT_MASK, REG_INT_MASK_AIE);
+    return true;
+}
+
+
+bool AB1805::interruptCountdownTimer(int value, bool minutes) {
+    static const char *errorMsg = "failure in interruptCountdownTimer %d";
+    bool bResult;
+
+    // Disable watchdog
+    bResult = setWDT(0);
     if (!bResult) {
         _log.error(errorMsg, __LINE__);
         return false;
     }
 
-    // Enable alarm
-    bResult = maskRegister(REG_TIMER_CTRL, ~REG_TIMER_CTRL_RPT_MASK, rptValue & REG_TIMER_CTRL_RPT_MASK);
+    RegisterBatch batch(*this);
+
+    // Set FOUT/nIRQ control in OUT1S in Control2 for 
+    // "nIRQ if at least one interrupt is enabled, else OUT"
+    batch.mask(REG_CTRL_2, ~REG_CTRL_2_OUT1S_MASK, REG_CTRL_2_OUT1S_nIRQ);
+
+    addCountdownTimer(batch, value, minutes);
+
+    bResult = batch.commit();
     if (!bResult) {
         _log.error(errorMsg, __LINE__);
         return false;
     }
-    
+
     return true;
 }
 
-bool AB1805::clearRepeatingInterrupt() {
-    static const char *errorMsg = "failure in clearRepeatingInterrupt %d";
-    bool bResult;
+bool AB1805::setCountdownTimerMillis(uint32_t ms) {
+    static const char *errorMsg = "failure in setCountdownTimerMillis %d";
 
-    // Set FOUT/nIRQ control in Control2 to the default value
-    bResult = maskRegister(REG_CTRL_2, ~REG_CTRL_2_OUT1S_MASK, REG_CTRL_2_OUT1S_nIRQ);
+    if (ms == 0) {
+        ms = 1;
+    }
+
+    if (!eventInterruptEnabled) {
+        // Checked before changing any registers, so a timer that can't be chained is not started
+        uint8_t oscCtrl;
+        if (!readRegister(REG_OSC_CTRL, oscCtrl)) {
+            _log.error(errorMsg, __LINE__);
+            return false;
+        }
+        uint8_t ticks, tfs;
+        if (countdownTimerSegment(ms, (oscCtrl & REG_OSC_CTRL_OSEL) != 0, ticks, tfs) < ms) {
+            _log.error("setCountdownTimerMillis %lu ms requires withEventInterrupt()", (unsigned long)ms);
+            return false;
+        }
+    }
+
+    periodicTickEnabled = periodicTickPulse = false;
+    countdownTimerMs = ms;
+    countdownTimerStart = millis();
+
+    return startCountdownTimerSegment(ms);
+}
+
+// [static]
+uint32_t AB1805::countdownTimerSegment(uint32_t ms, bool rcOscillator, uint8_t &ticks, uint8_t &tfs) {
+    // Countdown timer clocks from finest to coarsest, in ticks per minute
+    const uint32_t fastTicksPerMinute = rcOscillator ? (128 * 60) : (4096 * 60);
+    const uint32_t ticksPerMinute[4] = { fastTicksPerMinute, 64 * 60, 60, 1 };
+    const uint8_t tfsValues[4] = { REG_TIMER_CTRL_TFS_FAST, REG_TIMER_CTRL_TFS_64, REG_TIMER_CTRL_TFS_1, REG_TIMER_CTRL_TFS_1_60 };
+
+    // Finest clock that fits in 255 ticks, or 1/60 Hz if none do
+    size_t ii;
+    for(ii = 0; ii < 3; ii++) {
+        if ((uint64_t)ms * ticksPerMinute[ii] <= 255 * 60000ULL) {
+            break;
+        }
+    }
+    tfs = tfsValues[ii];
+
+    // exact is the number of ticks times 60000
+    uint64_t exact = (uint64_t)ms * ticksPerMinute[ii];
+    uint64_t whole = exact / 60000;
+    if (whole > 255) {
+        whole = 255;
+    }
+
+    uint32_t coveredMs = (uint32_t)((whole * 60000 + ticksPerMinute[ii] / 2) / ticksPerMinute[ii]);
+    if (whole == 0 || coveredMs + COUNTDOWN_TIMER_MIN_SEGMENT_MS > ms) {
+        // Remainder is too short for another segment, so round to the nearest tick
+        whole = (exact + 30000) / 60000;
+        if (whole < 1) {
+            whole = 1;
+        }
+        coveredMs = ms;
+    }
+    ticks = (uint8_t)whole;
+
+    return coveredMs;
+}
+
+bool AB1805::startCountdownTimerSegment(uint32_t ms) {
+    static const char *errorMsg = "failure in startCountdownTimerSegment %d";
+    uint8_t oscCtrl;
+
+    bool bResult = readRegister(REG_OSC_CTRL, oscCtrl);
     if (!bResult) {
         _log.error(errorMsg, __LINE__);
         return false;
     }
 
-    // Disable alarm interrupt (AIE) in interrupt mask register
-    bResult = clearRegisterBit(REG_INT_MASK, REG_INT_MASK_AIE);
+    uint8_t ticks, tfs;
+    uint32_t coveredMs = countdownTimerSegment(ms, (oscCtrl & REG_OSC_CTRL_OSEL) != 0, ticks, tfs);
+    if (coveredMs >= ms) {
+        // Last segment
+        countdownTimerMs = 0;
+    }
+
+    _log.trace("countdown timer segment %lu of %lu ms ticks=%u tfs=%u", (unsigned long)coveredMs, (unsigned long)ms, ticks, tfs);
+
+    RegisterBatch batch(*this);
+
+    // Set FOUT/nIRQ control in OUT1S in Control2 for 
+    // "nIRQ if at least one interrupt is enabled, else OUT"
+    batch.mask(REG_CTRL_2, ~REG_CTRL_2_OUT1S_MASK, REG_CTRL_2_OUT1S_nIRQ);
+
+    addCountdownTimerTicks(batch, ticks, tfs);
+
+    bResult = batch.commit();
     if (!bResult) {
         _log.error(errorMsg, __LINE__);
+        countdownTimerMs = 0;
+    }
+    return bResult;
+}
+
+bool AB1805::continueCountdownTimer() {
+    uint32_t elapsed = (uint32_t)(millis() - countdownTimerStart);
+    if (elapsed + COUNTDOWN_TIMER_MIN_SEGMENT_MS > countdownTimerMs) {
+        countdownTimerMs = 0;
         return false;
     }
+    return startCountdownTimerSegment(countdownTimerMs - elapsed);
+}
 
-    // Disable alarm
-    bResult = maskRegister(REG_TIMER_CTRL, ~REG_TIMER_CTRL_RPT_MASK, REG_TIMER_CTRL_RPT_DIS);
+bool AB1805::startPeriodicTick(uint32_t periodUs, PeriodicTickHandler handler, bool pulse) {
+    static const char *errorMsg = "failure in startPeriodicTick %d";
+
+    if (!eventInterruptEnabled) {
+        _log.error("startPeriodicTick requires withEventInterrupt()");
+        return false;
+    }
+
+    uint8_t oscCtrl;
+    bool bResult = readRegister(REG_OSC_CTRL, oscCtrl);
     if (!bResult) {
         _log.error(errorMsg, __LINE__);
         return false;
     }
 
+    uint8_t ticks, tfs;
+    periodicTickPeriodUs = periodicTickSettings(periodUs, (oscCtrl & REG_OSC_CTRL_OSEL) != 0, ticks, tfs);
+    periodicTickHandler = handler;
+    periodicTickCount = periodicTickMissed = 0;
+    countdownTimerMs = 0;
+
+    _log.trace("startPeriodicTick periodUs=%lu ticks=%u tfs=%u pulse=%d", (unsigned long)periodicTickPeriodUs, ticks, tfs, pulse);
+
+    RegisterBatch batch(*this);
+
+    // Set FOUT/nIRQ control in OUT1S in Control2 for 
+    // "nIRQ if at least one interrupt is enabled, else OUT"
+    batch.mask(REG_CTRL_2, ~REG_CTRL_2_OUT1S_MASK, REG_CTRL_2_OUT1S_nIRQ);
+
+    addCountdownTimerTicks(batch, ticks, tfs, REG_TIMER_CTRL_TRPT | (pulse ? REG_TIMER_CTRL_TM : 0));
+
+    ATOMIC_BLOCK() {
+        periodicTickPulses = 0;
+        periodicTickPulse = pulse;
+    }
+    periodicTickEnabled = true;
+    periodicTickLastMicros = micros();
+
+    bResult = batch.commit();
+    if (!bResult) {
+        _log.error(errorMsg, __LINE__);
+        periodicTickEnabled = periodicTickPulse = false;
+        return false;
+    }
+
+    return true;
+}
+
+bool AB1805::stopPeriodicTick() {
+    static const char *errorMsg = "failure in stopPeriodicTick %d";
+
+    periodicTickEnabled = periodicTickPulse = false;
+
+    // When the alarm is used by withAlarmTimers(), keep the alarm repeat setting
+    uint8_t keepMask = alarmTimersEnabled ? REG_TIMER_CTRL_RPT_MASK : 0x00;
+
+    RegisterBatch batch(*this);
+    batch.mask(REG_TIMER_CTRL, keepMask, REG_TIMER_CTRL_DEFAULT);
+    batch.clear(REG_INT_MASK, REG_INT_MASK_TIE);
+
+    bool bResult = batch.commit();
+    if (!bResult) {
+        _log.error(errorMsg, __LINE__);
+    }
+    return bResult;
+}
+
+// [static]
+uint32_t AB1805::periodicTickSettings(uint32_t periodUs, bool rcOscillator, uint8_t &ticks, uint8_t &tfs) {
+    // Countdown timer clocks from finest to coarsest, in ticks per minute
+    const uint32_t fastTicksPerMinute = rcOscillator ? (128 * 60) : (4096 * 60);
+    const uint32_t ticksPerMinute[4] = { fastTicksPerMinute, 64 * 60, 60, 1 };
+    const uint8_t tfsValues[4] = { REG_TIMER_CTRL_TFS_FAST, REG_TIMER_CTRL_TFS_64, REG_TIMER_CTRL_TFS_1, REG_TIMER_CTRL_TFS_1_60 };
+
+    // Finest clock where the period rounds to 255 ticks or fewer, or 1/60 Hz if none do
+    uint64_t whole = 0;
+    size_t ii;
+    for(ii = 0; ii < 4; ii++) {
+        whole = ((uint64_t)periodUs * ticksPerMinute[ii] + 30000000) / 60000000;
+        if (whole <= 255) {
+            break;
+        }
+    }
+    if (ii == 4) {
+        ii = 3;
+        whole = 255;
+    }
+    if (whole < 1) {
+        whole = 1;
+    }
+
+    // Periods above about 4,265 seconds round up to 72 minutes on the 1/60 Hz clock, which
+    // doesn't fit the uint32_t result, so stay at the longest whole period that does
+    const uint64_t maxWhole = ((uint64_t)UINT32_MAX * ticksPerMinute[ii]) / 60000000;
+    if (whole > maxWhole) {
+        whole = maxWhole;
+    }
+    ticks = (uint8_t)whole;
+    tfs = tfsValues[ii];
+
+    return (uint32_t)((whole * 60000000 + ticksPerMinute[ii] / 2) / ticksPerMinute[ii]);
+}
+
+bool AB1805::deepPowerDown(int seconds) {
+    _log.info("deepPowerDown %d", seconds);
+
+    if (seconds < 1) {
+        seconds = 1;
+    }
+    if (seconds > 255) {
+        seconds = 255;
+    }
+    return enterDeepPowerDown(DeepPowerDownWake::COUNTDOWN_SECONDS, (uint32_t)seconds, 0);
+}
+
+bool AB1805::deepPowerDownFor(std::chrono::seconds duration) {
+    int64_t seconds = duration.count();
+
+    _log.info("deepPowerDownFor %ld", (long)seconds);
+
+    if (seconds < 1) {
+        seconds = 1;
+    }
+    if (seconds <= 255) {
+        return enterDeepPowerDown(DeepPowerDownWake::COUNTDOWN_SECONDS, (uint32_t)seconds, 0);
+    }
+
+    // The alarm matches month, date, and time so it can't be more than a year
+    if (seconds > 365 * 86400) {
+        seconds = 365 * 86400;
+    }
+
+    time_t rtcTime;
+    if (getRtcAsTime(rtcTime)) {
+        return enterDeepPowerDown(DeepPowerDownWake::ALARM, (uint32_t)seconds, rtcTime + (time_t)seconds);
+    }
+
+    // RTC not set, so the alarm can't be used
+    uint32_t minutes = (uint32_t)((seconds + 59) / 60);
+    if (minutes > 255) {
+        _log.info("RTC not set, deepPowerDown limited to 255 minutes");
+        minutes = 255;
+    }
+    return enterDeepPowerDown(DeepPowerDownWake::COUNTDOWN_MINUTES, minutes * 60, 0);
+}
+
+bool AB1805::deepPowerDownUntil(time_t wakeTime) {
+    if (!Time.isValid()) {
+        _log.error("deepPowerDownUntil time not valid");
+        return false;
+    }
+    time_t now = Time.now();
+
+    return deepPowerDownFor(std::chrono::seconds((wakeTime > now) ? (wakeTime - now) : 1));
+}
+
+bool AB1805::getLastDeepPowerDown(DeepPowerDownRecord &record, time_t &actualWake) const {
+    if (deepPowerDownRecord.magic != DEEP_POWER_DOWN_MAGIC) {
+        return false;
+    }
+    record = deepPowerDownRecord;
+    actualWake = deepPowerDownActualWake;
     return true;
 }
 
+bool AB1805::loadDeepPowerDownRecord() {
+    static const char *errorMsg = "failure in loadDeepPowerDownRecord %d";
 
-bool AB1805::interruptCountdownTimer(int value, bool minutes) {
-    static const char *errorMsg = "failure in interruptCountdownTimer %d";
-    bool bResult;
-
-    // Disable watchdog
-    bResult = setWDT(0);
+    bool bResult = readRam(deepPowerDownRamAddr, (uint8_t *)&deepPowerDownRecord, sizeof(DeepPowerDownRecord));
     if (!bResult) {
         _log.error(errorMsg, __LINE__);
+        deepPowerDownRecord.magic = 0;
         return false;
     }
+    if (deepPowerDownRecord.magic != DEEP_POWER_DOWN_MAGIC) {
+        return true;
+    }
 
-    // Set FOUT/nIRQ control in OUT1S in Control2 for 
-    // "nIRQ if at least one interrupt is enabled, else OUT"
-    bResult = maskRegister(REG_CTRL_2, ~REG_CTRL_2_OUT1S_MASK, REG_CTRL_2_OUT1S_nIRQ);
+    // Cleared so a later reset that is not from deepPowerDown() is not reported
+    uint32_t magic = 0;
+    bResult = writeRam(deepPowerDownRamAddr, (const uint8_t *)&magic, sizeof(magic));
     if (!bResult) {
         _log.error(errorMsg, __LINE__);
-        return false;
     }
 
-    bResult = setCountdownTimer(value, minutes);
-    if (!bResult) {
-        _log.error(errorMsg, __LINE__);
-        return false;
+    if (wakeReason != WakeReason::DEEP_POWER_DOWN || !getRtcAsTime(deepPowerDownActualWake)) {
+        deepPowerDownRecord.magic = 0;
+        return bResult;
     }
 
-    return true;
+    _log.info("deepPowerDown planned wake %lu actual %lu (%ld sec)", (unsigned long)deepPowerDownRecord.plannedWake, 
+        (unsigned long)deepPowerDownActualWake, (long)(deepPowerDownActualWake - (time_t)deepPowerDownRecord.plannedWake));
+
+    return bResult;
 }
 
-bool AB1805::deepPowerDown(int seconds) {
+bool AB1805::enterDeepPowerDown(DeepPowerDownWake wake, uint32_t seconds, time_t wakeTime) {
     static const char *errorMsg = "failure in deepPowerDown %d";
     bool bResult;
 
-    _log.info("deepPowerDown %d", seconds);
+    time_t rtcTime;
+    bool rtcValid = getRtcAsTime(rtcTime);
+
+    if (wake == DeepPowerDownWake::ALARM && alarmTimersEnabled) {
+        time_t timerWake;
+        if (getNextAlarmTimerWake(timerWake) && timerWake < wakeTime) {
+            _log.info("deepPowerDown wake at alarm timer %lu", (unsigned long)timerWake);
+            wakeTime = timerWake;
+        }
+    }
+
+    if (wake == DeepPowerDownWake::ALARM && rtcValid && wakeTime < rtcTime + 2) {
+        // An overdue timer, or one due before the device can power down. With RPT_MON, a time in 
+        // the past would not match for a year.
+        wakeTime = rtcTime + 2;
+    }
+
+    if (alarmTimersEnabled) {
+        // Save the awake time for the duty cycle
+        updateAlarmTimers();
+    }
+
+    if (deepPowerDownRecordEnabled) {
+        if (rtcValid) {
+            DeepPowerDownRecord record = {};
+            record.magic = DEEP_POWER_DOWN_MAGIC;
+            record.sleepTime = (uint32_t)rtcTime;
+            record.plannedWake = (uint32_t)((wake == DeepPowerDownWake::ALARM) ? wakeTime : (rtcTime + seconds));
+            record.wake = (uint8_t)wake;
+            if (!writeRam(deepPowerDownRamAddr, (const uint8_t *)&record, sizeof(record))) {
+                _log.error(errorMsg, __LINE__);
+            }
+        }
+    }
 
     // Disable watchdog
     bResult = setWDT(0);
@@ -506,6 +2822,8 @@ bool AB1805::deepPowerDown(int seconds) {
         return false;
     }
 
+    RegisterBatch batch(*this);
+
 #ifdef SET_D8_LOW
     // With FeatherAB1905v1 board, setting D8 low prior to sleep is necessary
     // to prevent current leakage. In V1, D8 is pulled up to 3V3R. In V2 and
@@ -514,79 +2832,82 @@ bool AB1805::deepPowerDown(int seconds) {
 
     // Set Output Control Register 1 (0x30)
     // O1EN to 1 to enable FOUT/nIRQ in sleep mode.
-    bResult = setRegisterBit(REG_OCTRL, REG_OCTRL_O1EN);
-    if (!bResult) {
-        _log.error(errorMsg, __LINE__);
-        return false;
-    }
+    batch.set(REG_OCTRL, REG_OCTRL_O1EN);
 
     // Set OUT in Control1 to 0 so the FOUT/nIRQ pin goes low
-    bResult = clearRegisterBit(REG_CTRL_1, REG_CTRL_1_OUT);
-    if (!bResult) {
-        _log.error(errorMsg, __LINE__);
-        return false;
-    }
+    batch.clear(REG_CTRL_1, REG_CTRL_1_OUT);
 
     // Make sure SQW is disabled
-    bResult = writeRegister(REG_SQW, REG_SQW_DEFAULT);
-    if (!bResult) {
-        _log.error(errorMsg, __LINE__);
-        return false;
-    }
+    batch.write(REG_SQW, REG_SQW_DEFAULT);
 
     // Set OUT1S in Control2 to 01 so FOUT/nIRQ is set from SQW or OUT. Since SQW is off, this means OUT only.
     // Use this mode so FOUT/nIRQ (D8) won't be affected by the countdown timer nIRQ.
-    bResult = maskRegister(REG_CTRL_2, ~REG_CTRL_2_OUT1S_MASK, REG_CTRL_2_OUT1S_SQW);
-    if (!bResult) {
-        _log.error(errorMsg, __LINE__);
-        return false;
-    }
+    batch.mask(REG_CTRL_2, ~REG_CTRL_2_OUT1S_MASK, REG_CTRL_2_OUT1S_SQW);
 #endif
 
-    bResult = setCountdownTimer(seconds, false);
-    if (!bResult) {
-        _log.error(errorMsg, __LINE__);
-        return false;
+    if (wake == DeepPowerDownWake::ALARM) {
+        // Stop the countdown timer so it can't wake early, and clear its interrupt and any 
+        // pending TIM so nIRQ is not already asserted
+        countdownTimerMs = 0;
+        batch.clear(REG_TIMER_CTRL, REG_TIMER_CTRL_TE);
+        batch.clear(REG_INT_MASK, REG_INT_MASK_TIE);
+        batch.clear(REG_STATUS, REG_STATUS_TIM);
+        batch.barrier();
+
+        struct tm tmstruct;
+        gmtime_r(&wakeTime, &tmstruct);
+
+        // Match month, date, and time (once per year)
+        addRepeatingInterrupt(batch, &tmstruct, REG_TIMER_CTRL_RPT_MON);
+#ifdef SET_D8_LOW
+        // Keep OUT1S set to SQW from above so FOUT/nIRQ (D8) is not affected by the alarm nIRQ
+        batch.mask(REG_CTRL_2, ~REG_CTRL_2_OUT1S_MASK, REG_CTRL_2_OUT1S_SQW);
+#endif
+        batch.barrier();
+
+        // The hardware alarm no longer matches the timer queue, it's set again in setup() after waking
+        alarmTimerArmed = 0;
+    }
+    else {
+        // Ends with a barrier() after the timer is enabled
+        if (wake == DeepPowerDownWake::COUNTDOWN_MINUTES) {
+            addCountdownTimer(batch, (int)(seconds / 60), true);
+        }
+        else {
+            addCountdownTimer(batch, (int)seconds, false);
+        }
     }
 
     // Make sure STOP (stop clocking system is 0, otherwise sleep mode cannot be entered)
     // PWR2 = 1 (low resistance power switch)
     // (also would probably work with PWR2 = 0, as nIRQ2 should be high-true for sleep mode)
-    bResult = maskRegister(REG_CTRL_1, (uint8_t)~(REG_CTRL_1_STOP | REG_CTRL_1_RSP), REG_CTRL_1_PWR2);
-    if (!bResult) {
-        _log.error(errorMsg, __LINE__);
-        return false;
-    }
+    batch.mask(REG_CTRL_1, (uint8_t)~(REG_CTRL_1_STOP | REG_CTRL_1_RSP), REG_CTRL_1_PWR2);
 
     // Disable the I/O interface in sleep
-    bResult = setRegisterBit(REG_OSC_CTRL, REG_OSC_CTRL_PWGT);
-    if (!bResult) {
-        _log.error(errorMsg, __LINE__);
-        return false;
-    }
+    batch.set(REG_OSC_CTRL, REG_OSC_CTRL_PWGT);
 
     // OUT2S = 6 to enable sleep mode
-    bResult = maskRegister(REG_CTRL_2, (uint8_t)~REG_CTRL_2_OUT2S_MASK, REG_CTRL_2_OUT2S_SLEEP);
-    if (!bResult) {
-        _log.error(errorMsg, __LINE__);
-        return false;
-    }
+    batch.mask(REG_CTRL_2, (uint8_t)~REG_CTRL_2_OUT2S_MASK, REG_CTRL_2_OUT2S_SLEEP);
+
+    // Enter sleep mode and set nRST low. This must be the last write.
+    batch.barrier();
+    batch.write(REG_SLEEP_CTRL, REG_SLEEP_CTRL_SLP | REG_SLEEP_CTRL_SLRES);
 
-    // Enter sleep mode and set nRST low
-    bResult = writeRegister(REG_SLEEP_CTRL, REG_SLEEP_CTRL_SLP | REG_SLEEP_CTRL_SLRES);
+    bResult = batch.commit();
     if (!bResult) {
         _log.error(errorMsg, __LINE__);
         return false;
     }
 
-    // _log.trace("delay in case we didn't power down");   
+    // Only reached if the power down did not occur. Wait up to the duration (maximum 255 seconds)
+    // in case the caller relies on not running during that time, without accessing the I2C bus.
     unsigned long start = millis();
-    while(millis() - start < (unsigned long) (seconds * 1000)) {
-        _log.info("REG_SLEEP_CTRL=0x%2x", readRegister(REG_SLEEP_CTRL));
-        delay(1000);
+    unsigned long waitMs = ((seconds < 255) ? seconds : 255) * 1000UL;
+    while(millis() - start < waitMs) {
+        delay(100);
     }
 
-    _log.error("didn't power down");
+    _log.error("didn't power down REG_SLEEP_CTRL=0x%02x", readRegister(REG_SLEEP_CTRL));
     System.reset();
 
     return true;
@@ -656,51 +2977,61 @@ bool AB1805::setCountdownTimer(int value, bool minutes) {
     static const char *errorMsg = "failure in setCountdownTimer %d";
     bool bResult;
 
-    // Clear any pending interrupts
-    bResult = writeRegister(REG_STATUS, REG_STATUS_DEFAULT);
-    if (!bResult) {
-        _log.error(errorMsg, __LINE__);
-        return false;
-    }
+    RegisterBatch batch(*this);
+
+    addCountdownTimer(batch, value, minutes);
 
-    // Stop countdown timer if already running since it can't be set while running
-    bResult = writeRegister(REG_TIMER_CTRL, REG_TIMER_CTRL_DEFAULT);
+    bResult = batch.commit();
     if (!bResult) {
         _log.error(errorMsg, __LINE__);
         return false;
     }
 
-    // Set countdown timer duration
+    return true;
+}
+
+void AB1805::addCountdownTimer(RegisterBatch &batch, int value, bool minutes) {
+    // Cancels any setCountdownTimerMillis() in progress or startPeriodicTick()
+    countdownTimerMs = 0;
+    periodicTickEnabled = periodicTickPulse = false;
+
     if (value < 1) {
         value = 1;
     }
     if (value > 255) {
         value = 255;
     }
-    bResult = writeRegister(REG_TIMER, (uint8_t)value);
-    if (!bResult) {
-        _log.error(errorMsg, __LINE__);
-        return false;
-    }
-
-    // Enable countdown timer interrupt (TIE = 1) in IntMask
-    bResult = setRegisterBit(REG_INT_MASK, REG_INT_MASK_TIE);
-    if (!bResult) {
-        _log.error(errorMsg, __LINE__);
-        return false;
-    }
 
     // Set the TFS frequency to 1/60 Hz for minutes or 1 Hz for seconds 
-    uint8_t tfs = (minutes ? REG_TIMER_CTRL_TFS_1_60 : REG_TIMER_CTRL_TFS_1);
+    addCountdownTimerTicks(batch, (uint8_t)value, minutes ? REG_TIMER_CTRL_TFS_1_60 : REG_TIMER_CTRL_TFS_1);
+}
 
-    // Enable countdown timer (TE = 1) in countdown timer control register
-    bResult = writeRegister(REG_TIMER_CTRL, REG_TIMER_CTRL_TE | tfs);
-    if (!bResult) {
-        _log.error(errorMsg, __LINE__);
-        return false;
+void AB1805::addCountdownTimerTicks(RegisterBatch &batch, uint8_t ticks, uint8_t tfs, uint8_t flags) {
+    // Clear any pending interrupts
+    batch.write(REG_STATUS, REG_STATUS_DEFAULT);
+
+    // When the alarm is used by withAlarmTimers(), keep the alarm repeat setting
+    uint8_t keepMask = alarmTimersEnabled ? REG_TIMER_CTRL_RPT_MASK : 0x00;
+
+    // Stop countdown timer if already running since it can't be set while running.
+    // REG_TIMER_CTRL is immediately before REG_TIMER so this is a single write
+    // and the timer is stopped before the value is changed.
+    batch.mask(REG_TIMER_CTRL, keepMask, REG_TIMER_CTRL_DEFAULT);
+
+    // Set countdown timer duration
+    batch.write(REG_TIMER, ticks);
+    if ((flags & REG_TIMER_CTRL_TRPT) != 0) {
+        // The timer is reloaded one tick after reaching 0, so the repeat period is REG_TIMER_INITIAL + 1
+        batch.write(REG_TIMER_INITIAL, (uint8_t)(ticks - 1));
     }
+    batch.barrier();
 
-    return true;
+    // Enable countdown timer interrupt (TIE = 1) in IntMask
+    batch.set(REG_INT_MASK, REG_INT_MASK_TIE);
+
+    // Enable countdown timer (TE = 1) in countdown timer control register
+    batch.mask(REG_TIMER_CTRL, keepMask, REG_TIMER_CTRL_TE | (flags & (REG_TIMER_CTRL_TM | REG_TIMER_CTRL_TRPT)) | (tfs & REG_TIMER_CTRL_TFS_MASK));
+    batch.barrier();
 }
 
 
@@ -715,6 +3046,13 @@ bool AB1805::readRegisters(uint8_t regAddr, uint8_t *array, size_t num, bool loc
         wire.lock();
     }
 
+    if (registerCacheEnabled && readRegisterCache(regAddr, array, num)) {
+        if (lock) {
+            wire.unlock();
+        }
+        return true;
+    }
+
     wire.beginTransmission(i2cAddr);
     wire.write(regAddr);
     int stat = wire.endTransmission(false);
@@ -728,6 +3066,9 @@ bool AB1805::readRegisters(uint8_t regAddr, uint8_t *array, size_t num, bool loc
             // _log.dump(array, num);
             // _log.print("\n");
 
+            if (registerCacheEnabled) {
+                updateRegisterCache(regAddr, array, num, false);
+            }
             bResult = true;
         }
         else {
@@ -782,6 +3123,40 @@ bool AB1805::writeRegisters(uint8_t regAddr, const uint8_t *array, size_t num, b
         _log.error("failed to write regAddr=%02x stat=%d", regAddr, stat);
     }
 
+    if (registerCacheEnabled) {
+        if (bResult) {
+            updateRegisterCache(regAddr, array, num, true);
+        }
+        else {
+            // Unknown how much of the write succeeded
+            invalidateRegisterCache();
+            lastConfigKey = 0;
+        }
+    }
+
+    if (lock) {
+        wire.unlock();
+    }
+    return bResult;
+}
+
+bool AB1805::writeRegistersWithKey(uint8_t key, uint8_t regAddr, const uint8_t *array, size_t num, bool lock) {
+    bool bResult;
+
+    if (lock) {
+        wire.lock();
+    }
+
+    // The key only applies to the next write transaction, and the datasheet does not say it covers
+    // every register of a burst, so each register gets its own key write (same as setTrickle())
+    bResult = true;
+    for(size_t ii = 0; bResult && ii < num; ii++) {
+        bResult = writeRegister(REG_CONFIG_KEY, key, false);
+        if (bResult) {
+            bResult = writeRegister((uint8_t)(regAddr + ii), array[ii], false);
+        }
+    }
+
     if (lock) {
         wire.unlock();
     }
@@ -812,6 +3187,82 @@ bool AB1805::maskRegister(uint8_t regAddr, uint8_t andValue, uint8_t orValue, bo
     return bResult;
 }
 
+bool AB1805::loadRegisterCache() {
+    uint8_t array[REG_CACHE_SIZE];
+    bool bResult;
+
+    wire.lock();
+
+    registerCacheValid = 0;
+
+    // The I2C buffer is 32 bytes, so this is done in two reads
+    bResult = readRegisters(REG_CACHE_FIRST, array, 32, false);
+    if (bResult) {
+        bResult = readRegisters(REG_CACHE_FIRST + 32, &array[32], REG_CACHE_SIZE - 32, false);
+    }
+
+    wire.unlock();
+
+    if (!bResult) {
+        _log.error("failed to load register cache");
+    }
+
+    return bResult;
+}
+
+bool AB1805::readRegisterCache(uint8_t regAddr, uint8_t *array, size_t num) const {
+    for(size_t ii = 0; ii < num; ii++) {
+        size_t addr = regAddr + ii;
+        if (addr > 0xff || !isRegisterCacheable((uint8_t)addr) || (registerCacheValid & (1ULL << (addr - REG_CACHE_FIRST))) == 0) {
+            return false;
+        }
+    }
+    memcpy(array, &registerCache[regAddr - REG_CACHE_FIRST], num);
+    return true;
+}
+
+void AB1805::updateRegisterCache(uint8_t regAddr, const uint8_t *array, size_t num, bool isWrite) {
+    uint8_t configKey = lastConfigKey;
+
+    for(size_t ii = 0; ii < num; ii++) {
+        size_t addr = regAddr + ii;
+        if (addr > 0xff) {
+            break;
+        }
+
+        if (isWrite && addr == REG_CONFIG_KEY && array[ii] == REG_CONFIG_KEY_SW_RESET) {
+            // Software reset puts all registers back to power-on values
+            invalidateRegisterCache();
+            return;
+        }
+
+        if (!isRegisterCacheable((uint8_t)addr)) {
+            continue;
+        }
+        uint64_t bit = 1ULL << (addr - REG_CACHE_FIRST);
+
+        if (isWrite) {
+            uint8_t requiredKey = configKeyForRegister((uint8_t)addr);
+            if (requiredKey != 0 && requiredKey != configKey) {
+                // The chip will have ignored this write, so we no longer know the value
+                registerCacheValid &= ~bit;
+                continue;
+            }
+        }
+
+        registerCache[addr - REG_CACHE_FIRST] = array[ii];
+        registerCacheValid |= bit;
+    }
+
+    if (isWrite) {
+        // The configuration key only applies to the next write
+        lastConfigKey = 0;
+        if (regAddr <= REG_CONFIG_KEY && (regAddr + num) > REG_CONFIG_KEY) {
+            lastConfigKey = array[REG_CONFIG_KEY - regAddr];
+        }
+    }
+}
+
 bool AB1805::isBitClear(uint8_t regAddr, uint8_t bitMask, bool lock) {
     bool bResult;
     uint8_t value;
@@ -839,6 +3290,193 @@ bool AB1805::setRegisterBit(uint8_t regAddr, uint8_t bitMask, bool lock) {
     return maskRegister(regAddr, 0xff, bitMask, lock);
 }
 
+// [static]
+uint8_t AB1805::configKeyForRegister(uint8_t regAddr) {
+    switch(regAddr) {
+        case REG_OSC_CTRL:
+            return REG_CONFIG_KEY_OSC_CTRL;
+
+        case REG_TRICKLE:
+        case REG_BREF_CTRL:
+        case REG_AFCTRL:
+        case REG_BATMODE_IO:
+        case REG_OCTRL:
+            return REG_CONFIG_KEY_OTHER;
+
+        default:
+            return 0;
+    }
+}
+
+AB1805::RegisterBatch &AB1805::RegisterBatch::writeBlock(uint8_t regAddr, const uint8_t *array, size_t num) {
+    for(size_t ii = 0; ii < num; ii++) {
+        write((uint8_t)(regAddr + ii), array[ii]);
+    }
+    return *this;
+}
+
+AB1805::RegisterBatch &AB1805::RegisterBatch::mask(uint8_t regAddr, uint8_t andValue, uint8_t orValue) {
+    if (regAddr > MAX_REG_ADDR) {
+        overflow = true;
+        return *this;
+    }
+
+    // Combine with an earlier change to the same register in this stage
+    for(size_t ii = 0; ii < numEntries; ii++) {
+        Entry &e = entries[ii];
+        if (e.regAddr == regAddr && e.stage == stage) {
+            e.orValue = (uint8_t)((e.orValue & andValue) | orValue);
+            e.andValue &= andValue;
+            return *this;
+        }
+    }
+
+    if (numEntries >= MAX_ENTRIES) {
+        overflow = true;
+        return *this;
+    }
+
+    Entry &e = entries[numEntries++];
+    e.regAddr = regAddr;
+    e.andValue = andValue;
+    e.orValue = orValue;
+    e.stage = stage;
+
+    return *this;
+}
+
+AB1805::RegisterBatch &AB1805::RegisterBatch::barrier() {
+    if (numEntries > 0 && entries[numEntries - 1].stage == stage) {
+        stage++;
+    }
+    return *this;
+}
+
+void AB1805::RegisterBatch::reset() {
+    numEntries = 0;
+    stage = 0;
+    overflow = false;
+}
+
+bool AB1805::RegisterBatch::commit(bool lock) {
+    bool bResult = true;
+    uint8_t current[MAX_REG_ADDR + 1];
+    uint64_t known = 0;     // Bits set in known have a valid value in current
+    uint64_t needRead = 0;
+
+    if (overflow) {
+        _log.error("register batch overflow");
+        reset();
+        return false;
+    }
+
+    if (lock) {
+        parent.wire.lock();
+    }
+
+    // Registers whose first change in the batch is partial (masked) need their current value.
+    // Look in the shadow register cache first, then read the rest in one burst.
+    uint64_t seen = 0;
+    for(size_t ii = 0; ii < numEntries; ii++) {
+        const Entry &e = entries[ii];
+        uint64_t bit = 1ULL << e.regAddr;
+        if ((seen & bit) == 0) {
+            seen |= bit;
+            if (e.andValue != 0x00) {
+                if (parent.registerCacheEnabled && parent.readRegisterCache(e.regAddr, &current[e.regAddr], 1)) {
+                    known |= bit;
+                }
+                else {
+                    needRead |= bit;
+                }
+            }
+        }
+    }
+    if (needRead) {
+        uint8_t first = 0, last = MAX_REG_ADDR;
+        while((needRead & (1ULL << first)) == 0) {
+            first++;
+        }
+        while((needRead & (1ULL << last)) == 0) {
+            last--;
+        }
+        // The span is at most 64 bytes, but a single I2C read is limited to 32 bytes
+        for(uint8_t regAddr = first; bResult && regAddr <= last; regAddr += 32) {
+            size_t num = last - regAddr + 1;
+            if (num > 32) {
+                num = 32;
+            }
+            bResult = parent.readRegisters(regAddr, &current[regAddr], num, false);
+        }
+        if (bResult) {
+            for(uint8_t regAddr = first; regAddr <= last; regAddr++) {
+                known |= 1ULL << regAddr;
+            }
+        }
+    }
+
+    for(uint8_t curStage = 0; bResult && curStage <= stage; curStage++) {
+        uint8_t newValues[MAX_REG_ADDR + 1];
+        uint64_t toWrite = 0;
+
+        for(size_t ii = 0; ii < numEntries; ii++) {
+            const Entry &e = entries[ii];
+            if (e.stage != curStage) {
+                continue;
+            }
+            uint64_t bit = 1ULL << e.regAddr;
+
+            uint8_t value = e.orValue;
+            if (e.andValue != 0x00) {
+                value |= current[e.regAddr] & e.andValue;
+            }
+
+            // Drop writes that don't change anything. Full writes to registers that the chip
+            // can change by itself (status, timer, sleep control) are always done.
+            if ((known & bit) != 0 && value == current[e.regAddr] && (e.andValue != 0x00 || isRegisterCacheable(e.regAddr))) {
+                continue;
+            }
+            newValues[e.regAddr] = value;
+            toWrite |= bit;
+        }
+
+        // Write runs of adjacent registers that share the same key requirement
+        uint8_t regAddr = 0;
+        while(bResult && toWrite != 0) {
+            while((toWrite & (1ULL << regAddr)) == 0) {
+                regAddr++;
+            }
+            uint8_t key = configKeyForRegister(regAddr);
+            uint8_t num = 1;
+            while(regAddr + num <= MAX_REG_ADDR && num < 31 &&
+                (toWrite & (1ULL << (regAddr + num))) != 0 &&
+                configKeyForRegister(regAddr + num) == key) {
+                num++;
+            }
+
+            if (key != 0) {
+                bResult = parent.writeRegistersWithKey(key, regAddr, &newValues[regAddr], num, false);
+            }
+            else {
+                bResult = parent.writeRegisters(regAddr, &newValues[regAddr], num, false);
+            }
+            for(uint8_t ii = 0; ii < num; ii++, regAddr++) {
+                current[regAddr] = newValues[regAddr];
+                known |= 1ULL << regAddr;
+                toWrite &= ~(1ULL << regAddr);
+            }
+        }
+    }
+
+    if (lock) {
+        parent.wire.unlock();
+    }
+
+    reset();
+
+    return bResult;
+}
+
 /**
  * @brief Erases the RTC RAM to 0x00
  */
@@ -977,53 +3615,82 @@ String AB1805::tmToString(const struct tm *timeptr) {
 
 // [static] 
 void AB1805::tmToRegisters(const struct tm *timeptr, uint8_t *array, bool includeYear) {
-    uint8_t *p = array;
-    *p++ = valueToBcd(timeptr->tm_sec);
-    *p++ = valueToBcd(timeptr->tm_min);
-    *p++ = valueToBcd(timeptr->tm_hour);
-    *p++ = valueToBcd(timeptr->tm_mday);
-    *p++ = valueToBcd(timeptr->tm_mon + 1); // struct tm is 0-11, not 1-12!
+    uint8_t values[7];
+    size_t num = 0;
+
+    values[num++] = (uint8_t)timeptr->tm_sec;
+    values[num++] = (uint8_t)timeptr->tm_min;
+    values[num++] = (uint8_t)timeptr->tm_hour;
+    values[num++] = (uint8_t)timeptr->tm_mday;
+    values[num++] = (uint8_t)(timeptr->tm_mon + 1); // struct tm is 0-11, not 1-12!
     if (includeYear) {
-        *p++ = valueToBcd(timeptr->tm_year % 100);
+        values[num++] = (uint8_t)(timeptr->tm_year % 100);
     }
-    *p++ = valueToBcd(timeptr->tm_wday);
+    values[num++] = (uint8_t)timeptr->tm_wday;
+
+    storeBlock(valuesToBcdBlock(loadBlock(values, num)), array, num);
 }
 
 
 // [static] 
 void AB1805::registersToTm(const uint8_t *array, struct tm *timeptr, bool includeYear) {
-    const uint8_t *p = array;
-    timeptr->tm_sec = bcdToValue(*p++);
-    timeptr->tm_min = bcdToValue(*p++);
-    timeptr->tm_hour = bcdToValue(*p++);
-    timeptr->tm_mday = bcdToValue(*p++);
-    timeptr->tm_mon = bcdToValue(*p++) - 1; // struct tm is 0-11, not 1-12!
+    // Remove the GP bits. Without the year, the weekday mask moves down one byte.
+    uint64_t fieldMask = includeYear ? (TIME_BLOCK_FIELD_MASK >> 8) : 0x0000071f3f3f7f7fULL;
+    uint8_t values[7];
+    const uint8_t *p = values;
+
+    storeBlock(bcdBlockToValues(loadBlock(array, includeYear ? 7 : 6) & fieldMask), values, 7);
+
+    timeptr->tm_sec = *p++;
+    timeptr->tm_min = *p++;
+    timeptr->tm_hour = *p++;
+    timeptr->tm_mday = *p++;
+    timeptr->tm_mon = *p++ - 1; // struct tm is 0-11, not 1-12!
     if (includeYear) {
-        timeptr->tm_year = bcdToValue(*p++) + 100;
+        timeptr->tm_year = *p++ + 100;
     }
-    timeptr->tm_wday = bcdToValue(*p++);
-}
-
-// [static] 
-int AB1805::bcdToValue(uint8_t bcd) {
-    return (bcd >> 4) * 10 + (bcd & 0x0f);
-}
-
-// [static] 
-uint8_t AB1805::valueToBcd(int value) {
-    int tens = (value / 10) % 10;
-    int ones = value % 10;
-
-    return (uint8_t) ((tens << 4) | ones);
+    timeptr->tm_wday = *p++;
 }
 
 
 void AB1805::systemEvent(system_event_t event, int param) {
     if (event == reset) {
-        if (watchdogSecs != 0) {
+        // Ending a budget must not turn the watchdog back on
+        watchdogBudgetSavedMillis = 0;
+        if (watchdogMillis != 0) {
             setWDT(0);
         }
     }
+    else
+    if (event == network_status) {
+        if (param == network_status_powering_on || param == network_status_connecting) {
+            beginWatchdogBudget(WATCHDOG_PHASE_NETWORK_CONNECT, systemWatchdogBudget[WATCHDOG_PHASE_NETWORK_CONNECT]);
+        }
+        else
+        if (param == network_status_connected || param == network_status_off) {
+            endWatchdogBudget(WATCHDOG_PHASE_NETWORK_CONNECT);
+        }
+    }
+    else
+    if (event == cloud_status) {
+        if (param == cloud_status_connecting) {
+            beginWatchdogBudget(WATCHDOG_PHASE_CLOUD_CONNECT, systemWatchdogBudget[WATCHDOG_PHASE_CLOUD_CONNECT]);
+        }
+        else
+        if (param == cloud_status_connected || param == cloud_status_disconnected) {
+            endWatchdogBudget(WATCHDOG_PHASE_CLOUD_CONNECT);
+        }
+    }
+    else
+    if (event == firmware_update) {
+        if (param == firmware_update_begin) {
+            beginWatchdogBudget(WATCHDOG_PHASE_FIRMWARE_UPDATE, systemWatchdogBudget[WATCHDOG_PHASE_FIRMWARE_UPDATE]);
+        }
+        else
+        if (param == firmware_update_complete || param == firmware_update_failed) {
+            endWatchdogBudget(WATCHDOG_PHASE_FIRMWARE_UPDATE);
+        }
+    }
 }
 
 // [static] 
@@ -4,6 +4,7 @@
 #include "Particle.h"
 
 #include <time.h> // struct tm
+#include <chrono>
 
 /**
  * @brief Class for using the AB1805/AM1805 RTC/watchdog chip
@@ -26,6 +27,8 @@ public:
         ALARM               //!< RTC clock alarm (periodic or single) trigged wake
     };
 
+    class RegisterBatch;
+
     /**
      * @brief Construct the AB1805 driver object
      *
@@ -74,6 +77,49 @@ public:
      */
     AB1805 &withFOUT(pin_t pin) { foutPin = pin; return *this; };
 
+    /**
+     * @brief Call this before AB1805::setup() to enable the shadow register cache
+     *
+     * @param enable true to enable the cache (default), false to disable it
+     *
+     * @return An AB1805& so you can chain the withXXX() calls, fluent-style-
+     * then call the AB1805::setup() method.
+     *
+     * When enabled, the configuration registers (0x10 - 0x30) are read in a burst during
+     * setup() and a copy is kept in RAM. Every write through this object updates the copy
+     * (write-through), so read-modify-write operations like maskRegister(), setRegisterBit()
+     * and clearRegisterBit() only need the write transaction on the I2C bus.
+     *
+     * Registers that the chip changes on its own (REG_SLEEP_CTRL, REG_TIMER_CTRL, REG_TIMER,
+     * REG_WDT, REG_OSC_STATUS, REG_CONFIG_KEY, REG_ASTAT) are never cached and always
+     * read from the chip. REG_STATUS and the time registers are outside of the cached range.
+     *
+     * If you modify the AB1805 registers from outside of this object (another library
+     * that accesses the chip directly), call invalidateRegisterCache() afterwards.
+     */
+    AB1805 &withRegisterCache(bool enable = true) { registerCacheEnabled = enable; return *this; };
+
+    /**
+     * @brief Discards the contents of the shadow register cache
+     *
+     * The next read of each cached register will go to the chip and repopulate the cache.
+     * This is only necessary if something other than this object modified the registers.
+     */
+    void invalidateRegisterCache() { registerCacheValid = 0; };
+
+    /**
+     * @brief Returns true if the register can be held in the shadow register cache
+     *
+     * @param regAddr Register address (0x00 - 0xff)
+     *
+     * Only the configuration registers 0x10 - 0x30 are cacheable, excluding the registers
+     * that can be changed by the chip itself.
+     */
+    static bool isRegisterCacheable(uint8_t regAddr) {
+        return regAddr >= REG_CACHE_FIRST && regAddr <= REG_CACHE_LAST &&
+            (REG_CACHE_VOLATILE_MASK & (1ULL << (regAddr - REG_CACHE_FIRST))) == 0;
+    }
+
 
     /**
      * @brief Checks the I2C bus to make sure there is an AB1805 present
@@ -114,586 +160,2238 @@ public:
      */
     bool updateWakeReason();
 
+    static const uint16_t WAKE_CAUSE_EX1 = 0x0001;          //!< getWakeCauses(), external interrupt EXTI (REG_STATUS_EX1)
+    static const uint16_t WAKE_CAUSE_EX2 = 0x0002;          //!< getWakeCauses(), external interrupt WDI (REG_STATUS_EX2)
+    static const uint16_t WAKE_CAUSE_ALM = 0x0004;          //!< getWakeCauses(), alarm (REG_STATUS_ALM)
+    static const uint16_t WAKE_CAUSE_TIM = 0x0008;          //!< getWakeCauses(), countdown timer (REG_STATUS_TIM)
+    static const uint16_t WAKE_CAUSE_BL = 0x0010;           //!< getWakeCauses(), battery voltage crossing (REG_STATUS_BL)
+    static const uint16_t WAKE_CAUSE_WDT = 0x0020;          //!< getWakeCauses(), watchdog (REG_STATUS_WDT)
+    static const uint16_t WAKE_CAUSE_SLST = 0x0100;         //!< getWakeCauses(), sleep mode was entered (REG_SLEEP_CTRL_SLST)
+    static const uint16_t WAKE_CAUSE_OSC_FAIL = 0x0200;     //!< getWakeCauses(), oscillator failure (REG_OSC_STATUS_OF)
+    static const uint16_t WAKE_CAUSE_STATUS_MASK = 0x003f;  //!< Causes that are REG_STATUS bits and are cleared by updateWakeReason()
+
+    static const size_t WAKE_STATUS_BLOCK_SIZE = 15;        //!< Number of bytes read by updateWakeReason(), REG_STATUS to REG_OSC_STATUS
+
     /**
-     * @brief Set or reset the watchdog timer. 
+     * @brief Gets all of the causes that were pending when updateWakeReason() was last called
      * 
-     * @param seconds Duration of watchdog timer or -1 to tickle/pet/service the watchdog. 
-     * 
-     * Minimum is 4 and maximum is 124 seconds. 0 disables the watchdog timer.
-     * The constant `WATCHDOG_MAX_SECONDS` is 124 and is a good choice. 
-     * -1 resets the timer to the previous setting and is used to tickle/pet/service the 
-     * watchdog timer. This is done from AB1805::loop().
+     * @return A bit mask of WAKE_CAUSE_EX1, WAKE_CAUSE_EX2, WAKE_CAUSE_ALM, WAKE_CAUSE_TIM, WAKE_CAUSE_BL, WAKE_CAUSE_WDT,
+     * WAKE_CAUSE_SLST, and WAKE_CAUSE_OSC_FAIL. 
      * 
-     * Periodically servicing the watchdog (-1) is handled automatically in AB1805::loop()
-     * so you normally don't need to worry about it. Since it requires an I2C transaction
-     * you probably don't want to call it on every loop. 
+     * getWakeReason() only returns the highest priority cause. The REG_STATUS causes are cleared in a 
+     * single write by updateWakeReason(). The oscillator failure flag (set on every cold power-up) is 
+     * also cleared, so WAKE_CAUSE_OSC_FAIL means a failure since the previous updateWakeReason(). 
+     * SLST is not cleared.
      */
-    bool setWDT(int seconds = -1);
+    uint16_t getWakeCauses() const { return wakeCauses; };
 
     /**
-     * @brief Stops the watchdog timer. Useful before entering sleep mode.
+     * @brief Decode the wake causes from the registers read by updateWakeReason()
      * 
-     * This is done automatically right before reset (using the reset system event)
-     * so the watchdog won't trigger during a firmware update. 
+     * @param array WAKE_STATUS_BLOCK_SIZE bytes starting at REG_STATUS
+     * 
+     * @return A bit mask of WAKE_CAUSE_* values
      */
-    bool stopWDT() { return setWDT(0); };
+    static uint16_t wakeCausesFromRegisters(const uint8_t *array);
 
     /**
-     * @brief Resumes watchdog with same settings as before
-     * 
-     * This is useful after returning from `System.sleep()` in STOP or ULTRA_LOW_POWER
-     * sleep modes where executinon continues. You may also want to call `updateWakeReason()`.
+     * @brief One boot or wake in the journal, saved in the RTC RAM (see withBootJournal())
      * 
-     * It's safe to call resumeWDT() even if the WDT has never been set, it does nothing
-     * in this case, leaving the watchdog off.
+     * Records are 8 bytes so up to BOOT_JOURNAL_MAX_RECORDS fit in the RTC RAM.
      */
-    bool resumeWDT() { return setWDT(-1); };
+    typedef struct {
+        uint32_t time;          //!< RTC time, seconds since January 1, 1970 UTC, or 0 if the RTC was not set
+        uint8_t hundredths;     //!< RTC hundredths of a second, 0 - 99
+        uint8_t status;         //!< Raw REG_STATUS before the wake reason flag was cleared
+        uint8_t sleepCtrl;      //!< Raw REG_SLEEP_CTRL
+        uint8_t info;           //!< WakeReason in bits 0 - 2, low 5 bits of the boot count in bits 3 - 7
+    } BootJournalRecord;
 
     /**
-     * @brief Get the time from the RTC as a time_t
+     * @brief Header of the boot journal in the RTC RAM, before the records
+     */
+    typedef struct {
+        uint32_t magic;         //!< BOOT_JOURNAL_MAGIC
+        uint32_t bootCount;     //!< Number of times AB1805::setup() has been called since the journal was created
+        uint8_t capacity;       //!< Number of records
+        uint8_t count;          //!< Number of valid records, up to capacity
+        uint8_t next;           //!< Index of the record to write next
+        uint8_t reserved;       //!< Reserved, currently 0
+    } BootJournalHeader;
+
+    static const uint32_t BOOT_JOURNAL_MAGIC = 0x41424337;  //!< Magic bytes to detect a valid boot journal in RTC RAM
+    static const size_t BOOT_JOURNAL_MAX_RECORDS = 30;      //!< Maximum capacity of the boot journal, limited by the 256 bytes of RTC RAM and the 5-bit boot count
+
+    /**
+     * @brief Bytes of RTC RAM used by withBootJournal() for a capacity
+     */
+    static constexpr size_t bootJournalRamSize(size_t capacity) { return sizeof(BootJournalHeader) + capacity * sizeof(BootJournalRecord); };
+
+    /**
+     * @brief Call this before AB1805::setup() to keep a journal of boots and wakes in the RTC RAM
      * 
-     * @param time Filled in with the number of second since January 1, 1970 UTC.
+     * @param ramAddr Address in the RTC RAM of the journal. bootJournalRamSize(capacity) bytes are used
+     * starting at this address, 140 bytes for 16 records.
      * 
-     * @return true on success or false if an error occurs.
+     * @param capacity Number of records, 1 to BOOT_JOURNAL_MAX_RECORDS. The oldest record is overwritten
+     * when the journal is full. Changing the capacity clears the journal.
      * 
-     * The time value is basically the same as what would be returned from `Time.now()`
-     * except it's retrieved from the AB1805 RTC instead of the system. However both
-     * should approximately equal to each other.
+     * @return An AB1805& so you can chain the withXXX() calls, fluent-style.
+     * 
+     * Each call to updateWakeReason(), including the one from AB1805::setup(), adds a record with the RTC 
+     * time, the wake reason, and the raw status registers. This makes it possible to count brownouts,
+     * watchdog resets, and wakes without publishing on every boot.
      */
-    bool getRtcAsTime(time_t &time);
+    AB1805 &withBootJournal(size_t ramAddr, size_t capacity = 16) { 
+        bootJournalEnabled = true; 
+        bootJournalRamAddr = ramAddr; 
+        bootJournalCapacity = (uint8_t)((capacity < 1) ? 1 : (capacity > BOOT_JOURNAL_MAX_RECORDS) ? BOOT_JOURNAL_MAX_RECORDS : capacity); 
+        return *this; 
+    };
 
     /**
-     * @brief Get the time from the RTC as a struct tm
+     * @brief Get the number of times AB1805::setup() has been called since the boot journal was created
      * 
-     * @param timeptr pointer to struct tm. Filled in with the current time, UTC.
+     * @return The boot count, or 0 if withBootJournal() was not used
+     */
+    uint32_t getBootCount() const { return bootJournalHeader.bootCount; };
+
+    /**
+     * @brief Get the number of records in the boot journal
+     */
+    size_t getBootJournalCount() const { return bootJournalHeader.count; };
+
+    /**
+     * @brief Read the most recent records of the boot journal
      * 
-     * @return true on success or false if an error occurs.
+     * @param records Array to fill in, oldest first
      * 
-     * Note: This uses mktime, which technically is local time, not UTC. However,
-     * the standard library is set at UTC as the local time. Using Time.zone() changes
-     * the timezone in the `Time` class but does not modifying the underling 
-     * standard C library, so mktime should always be UTC.
+     * @param maxRecords Number of entries in records
      * 
-     * The fields of the timeptr are:
-     * - tm_sec	  seconds after the minute	0-61 (usually 0-59)
-     * - tm_min	  minutes after the hour 0-59
-     * - tm_hour  hours since midnight 0-23
-     * - tm_mday  day of the month 1-31
-     * - tm_mon	  months since January 0-11 (not 1-12!)
-     * - tm_year  years since 1900 (note: 2020 = 120)
-     * - tm_wday  days since Sunday	0-6
+     * @return Number of records filled in
+     * 
+     * The records are read directly from the RTC RAM with at most two readRam() calls, as the journal is 
+     * a circular buffer. Use getBootJournalWakeReason() and getBootJournalBootCount() to decode the info field.
      */
-    bool getRtcAsTm(struct tm *timeptr);
+    size_t readBootJournal(BootJournalRecord *records, size_t maxRecords);
 
     /**
-     * @brief Resets the configuration of the AB1805 to default settings
-     * 
-     * @param flags flags to customize reset behavior (default: 0)
+     * @brief Get the wake reason of a boot journal record
+     */
+    static WakeReason getBootJournalWakeReason(const BootJournalRecord &record) { return (WakeReason)(record.info & 0x07); };
+
+    /**
+     * @brief Get the boot count of a boot journal record
      * 
-     * @return true on success or false if an error occurs.
+     * The record only has the low 5 bits of the boot count. The rest comes from getBootCount(), which works
+     * because the journal never spans more than BOOT_JOURNAL_MAX_RECORDS boots.
+     */
+    uint32_t getBootJournalBootCount(const BootJournalRecord &record) const { 
+        return bootJournalHeader.bootCount - ((bootJournalHeader.bootCount - (record.info >> 3)) & 0x1f); 
+    };
+
+    /**
+     * @brief Remove all records from the boot journal. The boot count is not changed.
+     */
+    bool clearBootJournal();
+
+    /**
+     * @brief Function called from AB1805::loop() when an RTC event occurs
      * 
-     * The only exception currently defined is `AB1805::RESET_PRESERVE_REPEATING_TIMER` that
-     * keeps repeating timers programmed when resetting configuration.
+     * The parameter is the value of REG_STATUS that was read. It can contain more than
+     * one event flag if several occurred at the same time.
      */
-    bool resetConfig(uint32_t flags = 0);
+    typedef std::function<void(uint8_t status)> EventHandler;
 
     /**
-     * @brief Set an interrupt at a time in the future using a time_t
+     * @brief Call this before AB1805::setup() to handle RTC events from the FOUT/nIRQ interrupt
      * 
-     * @param time The number of second after January 1, 1970 UTC. 
+     * @param pollPeriodMs Also check REG_STATUS this often, in milliseconds, in case an interrupt
+     * was missed. Default: 0 (only check when the interrupt occurs).
      * 
-     * @return true on success or false if an error occurs.
+     * @return An AB1805& so you can chain the withXXX() calls, fluent-style.
      * 
-     * This causes an interrupt on FOUT/nIRQ in the future. It will execute
-     * once. This can only be done if the RTC has been programmed with
-     * the current time, which it normally gets from the cloud at startup.
+     * The FOUT/nIRQ pin must be set using withFOUT(). A FALLING interrupt is attached to it and the
+     * interrupt service routine only sets a flag. AB1805::loop() then reads REG_STATUS once, clears the
+     * event flags with a single write, and calls the handlers registered with withEventHandler().
      * 
-     * There can only be one interrupt set. Setting at one-time or repeating interrupt
-     * removes any previously set interrupt time.
+     * When this is enabled, AB1805::loop() clears all of the event flags in REG_STATUS 
+     * (`EVENT_FLAGS_MASK`), even if there is no handler for them, otherwise nIRQ would stay
+     * asserted and no more interrupts would occur.
      */
-    bool interruptAtTime(time_t time);
+    AB1805 &withEventInterrupt(unsigned long pollPeriodMs = 0) { eventInterruptEnabled = true; eventPollPeriod = pollPeriodMs; return *this; };
 
     /**
-     * @brief Set an interrupt at a time in the future using a struct tm *.
+     * @brief Register a function to call when an RTC event occurs
      * 
-     * @param timeptr pointer to struct tm. This specifies the time (UTC).
+     * @param statusFlags The REG_STATUS flag for the event: `REG_STATUS_ALM`, `REG_STATUS_TIM`,
+     * `REG_STATUS_WDT`, `REG_STATUS_BL`, `REG_STATUS_EX1`, or `REG_STATUS_EX2`. You can logically OR
+     * several flags together to use the same handler for all of them.
      * 
-     * @return true on success or false if an error occurs.
+     * @param handler The function to call from AB1805::loop(). Pass an empty handler (nullptr) to remove it.
      * 
-     * This causes an interrupt on FOUT/nIRQ in the future. It will execute
-     * once. This can only be done if the RTC has been programmed with
-     * the current time, which it normally gets from the cloud at startup.
+     * @return An AB1805& so you can chain the withXXX() calls, fluent-style.
      * 
-     * Only the tm_sec, tm_min, tm_hour, tm_mday, tm_mon, and tm_year are 
-     * used. The tm_wday field is ignored. Note that tm_mon is 0-11, not 1-12.
+     * If more than one event occurs at the same time, the handlers are called once per flag
+     * in bit order, EX1 first and WDT last. Handlers are called from the thread that calls AB1805::loop(), not 
+     * from an interrupt, so it's safe to make I2C calls from them. Requires withEventInterrupt().
+     */
+    AB1805 &withEventHandler(uint8_t statusFlags, EventHandler handler);
+
+    /**
+     * @brief Read REG_STATUS, clear the event flags, and call the event handlers
      * 
-     * There can only be one interrupt set. Setting at one-time or repeating interrupt
-     * removes any previously set interrupt time.
+     * @return true on success or false if an error occurs
      * 
-     * The fields of the timeptr are:
-     * - tm_sec	  seconds after the minute	0-61 (usually 0-59)
-     * - tm_min	  minutes after the hour 0-59
-     * - tm_hour  hours since midnight 0-23
-     * - tm_mday  day of the month 1-31
-     * - tm_mon	  months since January 0-11 (not 1-12!)
-     * - tm_year  years since 1900 (note: 2020 = 120)
-     * - tm_wday  days since Sunday	0-6
+     * This is called from AB1805::loop() after the FOUT/nIRQ interrupt when withEventInterrupt()
+     * is used. You can also call it yourself, for example after a STOP mode System.sleep().
+     * 
+     * A flag that is set after REG_STATUS is read but before it is written back is cleared without
+     * being handled, as the chip does not have a way to clear only some flags atomically. The 
+     * window is a single I2C transaction.
      */
-    bool interruptAtTm(struct tm *timeptr);
+    bool processEvents();
 
     /**
-     * @brief Set a repeating interrupt
-     * 
-     * @param timeptr pointer to struct tm. This specifies the time (UTC).
+     * @brief Set or reset the watchdog timer. 
      * 
-     * @param rptValue a constant for which fields of timeptr are used.
+     * @param seconds Duration of watchdog timer or -1 to tickle/pet/service the watchdog. 
      * 
-     * @return true on success or false if an error occurs.
+     * Minimum is 1 and maximum is 124 seconds. 0 disables the watchdog timer.
+     * The constant `WATCHDOG_MAX_SECONDS` is 124 and is a good choice. 
+     * -1 resets the timer to the previous setting and is used to tickle/pet/service the 
+     * watchdog timer. This is done from AB1805::loop().
      * 
-     * This causes an interrupt on FOUT/nIRQ in the future, repeating.
-     * This can only be done if the RTC has been programmed with
-     * the current time, which it normally gets from the cloud at startup.
+     * Periodically servicing the watchdog (-1) is handled automatically in AB1805::loop()
+     * so you normally don't need to worry about it. Since it requires an I2C transaction
+     * you probably don't want to call it on every loop. 
      * 
-     * - `REG_TIMER_CTRL_RPT_SEC` tm_sec matches (once per minute)
-     * - `REG_TIMER_CTRL_RPT_MIN` tm_sec, tm_min match (once per hour)
-     * - `REG_TIMER_CTRL_RPT_HOUR` tm_sec, tm_min, tm_hour match (once per day)
-     * - `REG_TIMER_CTRL_RPT_WKDY` tm_sec, tm_min, tm_hour, tm_wday match (once per week)
-     * - `REG_TIMER_CTRL_RPT_DATE` tm_sec, tm_min, tm_hour, tm_mday match (once per month)
-     * - `REG_TIMER_CTRL_RPT_MON` tm_sec, tm_min, tm_hour, tm_mday, tm_mon match (once per year)
+     * This is the same as setWDTMillis() with seconds * 1000.
+     */
+    bool setWDT(int seconds = -1);
+
+    /**
+     * @brief Set the watchdog timer with millisecond resolution
      * 
-     * Note that tm_mon (month) is 0 - 11, not 1 - 12! 
+     * @param ms Duration of the watchdog timer in milliseconds, from 63 to 124000. 0 disables the watchdog timer.
      * 
-     * There can only be one interrupt set. Setting at one-time or repeating interrupt
-     * removes any previously set interrupt time.
+     * @return true on success or false if an error occurs.
      * 
-     * If you reset the AB1805 configuration using `resetConfig()`, the repeating timer
-     * will be cleared, unless you add the `AB1805::RESET_PRESERVE_REPEATING_TIMER` parameter 
-     * to preserve it.
+     * The finest watchdog clock (16 Hz, 4 Hz, 1 Hz, or 1/4 Hz) that can count the duration in 31
+     * ticks is used (see watchdogRegisterValue()), so up to 1937 ms has a resolution of 62.5 ms.
+     * AB1805::loop() services the watchdog at half of the actual duration, so loop() must be called
+     * more often than that. Use getWDTMillis() to get the actual duration.
      * 
-     * The fields of the timeptr are:
-     * - tm_sec	  seconds after the minute	0-61 (usually 0-59)
-     * - tm_min	  minutes after the hour 0-59
-     * - tm_hour  hours since midnight 0-23
-     * - tm_mday  day of the month 1-31
-     * - tm_mon	  months since January 0-11 (not 1-12!)
-     * - tm_year  years since 1900 (note: 2020 = 120)
-     * - tm_wday  days since Sunday	0-6
+     * While beginWatchdogBudget() has increased the duration, a shorter duration is only saved and is 
+     * set when the last phase ends.
      */
-    bool repeatingInterrupt(struct tm *timeptr, uint8_t rptValue);
+    bool setWDTMillis(uint32_t ms);
 
     /**
-     * @brief Clear repeating interrupt set with `repeatingInterrupt()`.
-
-     * @return true on success or false if an error occurs.
+     * @brief Get the actual watchdog duration in milliseconds, or 0 if disabled
      */
-    bool clearRepeatingInterrupt();
+    uint32_t getWDTMillis() const { return watchdogMillis; };
 
     /**
-     * @brief Interrupt at a time in the future, either in minutes or seconds
+     * @brief Get the REG_WDT value for a watchdog duration, without REG_WDT_RESET
      * 
-     * @param value Value in seconds or minutes. Must be 0 < value <= 255! 
+     * @param ms Duration in milliseconds. Must be > 0.
      * 
-     * @param minutes True if minutes, false if seconds
+     * @param actualMs Filled in with the actual duration in milliseconds
      * 
-     * @return true on success or false if an error occurs.
-
-     * The countdown timer works even if the RTC has not been set yet, but is more
-     * limited in range (maximum: 255 minutes).
+     * @return The BMB (bits 2 - 6) and WRB (bits 0 - 1) fields of REG_WDT
      */
-    bool interruptCountdownTimer(int value, bool minutes);
+    static uint8_t watchdogRegisterValue(uint32_t ms, uint32_t &actualMs);
 
     /**
-     * @brief Enters deep power down reset mode, using the EN pin
-     * 
-     * @param seconds number of seconds to power down. Must be 0 < seconds <= 255.
-     * The default is 30 seconds. If time-sensitive, 10 seconds is probably sufficient.
-     * 
-     * @return true on success or false if an error occurs.
-     * 
-     * This method powers down the MCU and cellular modem by using a combination
-     * of the EN and RST pins. This super-reset is similar to what would happen if
-     * you disconnected the battery.
+     * @brief Call this before AB1805::setup() to service the watchdog from a software timer instead of loop()
      * 
-     * It assumes that EN is connected to /nIRQ2 (PSW) on the AB1805 using an 
-     * N-channel MOSFET and RST is connected to /RESET on the AB1805.
+     * @param loopTimeoutMs If non-zero, the watchdog is only serviced if AB1805::loop() has been called 
+     * within this many milliseconds, so a hang in the loop thread still resets the device. 0 services
+     * the watchdog as long as the timer thread runs.
      * 
-     * After the deep reset finishes, the device will reboot and go back through
-     * setup() again. Calling getWakeReset() will return the reason `DEEP_POWER_DOWN`.
+     * @return An AB1805& so you can chain the withXXX() calls, fluent-style.
      * 
-     * This works even if the RTC has not been set yet.
+     * A Particle software Timer runs at half of the watchdog duration set with setWDT() or setWDTMillis() 
+     * and calls refreshWDT(), so code that blocks the loop thread for longer than the watchdog duration
+     * (but less than loopTimeoutMs) does not cause a reset. The watchdog supervisor clients 
+     * (withWatchdogSupervisor()) are also checked from the timer.
      */
-    bool deepPowerDown(int seconds = 30);
+    AB1805 &withWatchdogRefreshTimer(unsigned long loopTimeoutMs = 0) { watchdogTimerEnabled = true; watchdogLoopTimeout = loopTimeoutMs; return *this; };
 
     /**
-     * @brief Used internally by interruptCountdownTimer and deepPowerDown.
-     * 
-     * @param value Value in seconds or minutes. Must be 0 < value <= 255! 
-     * 
-     * @param minutes True if minutes, false if seconds
+     * @brief Service the watchdog
      * 
      * @return true on success or false if an error occurs.
      * 
-     * The countdown timer works even if the RTC has not been set yet, but is more
-     * limited in range (maximum: 255 minutes).
+     * This is a single write of the REG_WDT value computed by setWDTMillis(), without logging, so it can 
+     * be called often and from any thread. It does nothing if the watchdog is disabled. This is used by
+     * setWDT(-1) and AB1805::loop().
      */
-    bool setCountdownTimer(int value, bool minutes);
+    bool refreshWDT();
+
+    static const uint32_t WATCHDOG_SNAPSHOT_MAGIC = 0x41424336;     //!< Magic bytes to detect a valid WatchdogSnapshot in RTC RAM
+    static const uint8_t WATCHDOG_SNAPSHOT_LOOP_HUNG = 0x01;        //!< WatchdogSnapshot flags, AB1805::loop() was not called within loopTimeoutMs
+    static const uint8_t WATCHDOG_SNAPSHOT_CLIENT_LATE = 0x02;      //!< WatchdogSnapshot flags, a supervisor client missed its deadline
 
     /**
-     * @brief Enable trickle charging mode
+     * @brief State of the device when the watchdog expired, saved in the RTC RAM (see withWatchdogSnapshot())
+     */
+    typedef struct {
+        uint32_t magic;             //!< WATCHDOG_SNAPSHOT_MAGIC
+        uint32_t uptimeMs;          //!< millis() when the watchdog expired
+        uint32_t rtcTime;           //!< RTC time when the watchdog expired, seconds since January 1, 1970 UTC, or 0 if not set
+        uint32_t freeMemory;        //!< System.freeMemory() when the watchdog expired
+        uint32_t checkpointAddr;    //!< Code address that last called watchdogCheckpoint(), or 0
+        uint32_t loopAgeMs;         //!< Milliseconds since AB1805::loop() was last called
+        uint32_t heartbeatIds;      //!< Ids of the last 4 calls to watchdogHeartbeat(), most recent in the low byte
+        uint16_t checkpointId;      //!< Id passed to the last watchdogCheckpoint()
+        uint8_t lateClients;        //!< Bit mask of supervisor clients that missed their deadline
+        uint8_t flags;              //!< WATCHDOG_SNAPSHOT_LOOP_HUNG, WATCHDOG_SNAPSHOT_CLIENT_LATE
+    } WatchdogSnapshot;
+
+    static const size_t WATCHDOG_SNAPSHOT_RAM_SIZE = sizeof(WatchdogSnapshot); //!< Bytes of RTC RAM used by withWatchdogSnapshot()
+
+    /**
+     * @brief Call this before AB1805::setup() to save a snapshot in the RTC RAM before the watchdog resets the device
      * 
-     * @param diodeAndRout Pass 0 to disable the trickle charger or one diode constant and one rout constant below.
+     * @param ramAddr Address in the RTC RAM to save the snapshot. WATCHDOG_SNAPSHOT_RAM_SIZE (32) bytes 
+     * are used starting at this address.
      * 
-     * @return true on success or false if an error occurs.
+     * @return An AB1805& so you can chain the withXXX() calls, fluent-style.
      * 
-     * Diode settings determine the voltage applied to the supercap or battery in trickle charge mode.
-     * This is from VCC, which is generally 3V3, so this will be a voltage of 2.7V or 3.0V. This makes
-     * the trickle charger compatible with a wider variety of supercaps.
+     * The watchdog is set to interrupt (WIRQ, REG_WDT_RESET = 0) instead of reset. When the timer from
+     * withWatchdogRefreshTimer() has not serviced the watchdog for the watchdog duration, a thread
+     * (WATCHDOG_THREAD_STACK_SIZE bytes of stack) saves a WatchdogSnapshot, then sets the watchdog to 
+     * reset after 1/16 second. On the next boot, the snapshot is available from getWatchdogSnapshot(). 
+     * The WDT status flag is handled by the timer and thread, so it's not passed to processEvents() 
+     * handlers in this mode.
      * 
-     * - `REG_TRICKLE_DIODE_0_6` diode 0.6V drop
-     * - `REG_TRICKLE_DIODE_0_3` diode 0.3V drop
+     * Requires withWatchdogRefreshTimer(), as the loop thread is usually the one that is hung. The reset
+     * depends on the timer and watchdog threads running and getting the I2C lock (wire.lock()), so if they
+     * do not run, or a thread hangs while holding the I2C lock, the device is not reset. You may want 
+     * to use the MCU hardware watchdog as well.
+     */
+    AB1805 &withWatchdogSnapshot(size_t ramAddr) { snapshotEnabled = true; snapshotRamAddr = ramAddr; return *this; };
+
+    /**
+     * @brief Record the place in the code for the watchdog snapshot
      * 
-     * The ROUT setting determines the series resistor to the supercap. This determines charging speed.
+     * @param id A number for the place in the code, saved in WatchdogSnapshot.checkpointId
      * 
-     * - `REG_TRICKLE_ROUT_11K` rout 11K
-     * - `REG_TRICKLE_ROUT_6K` rout 6K
-     * - `REG_TRICKLE_ROUT_3K` rout 3K
+     * The address of the code that calls this is saved in WatchdogSnapshot.checkpointAddr, which 
+     * you can look up in the .map file or with addr2line. This only saves two values so it can be
+     * called often from any thread.
+     */
+    void watchdogCheckpoint(uint16_t id = 0);
+
+    /**
+     * @brief Get the snapshot saved before the last watchdog reset
      * 
-     * The sample design includes an additional 1.5K series resistance using an external resistor, so
-     * applying 3K results in an actual series resistance of 4.5K.
+     * @param snapshot Filled in with the snapshot
      * 
+     * @return true if there is a snapshot, or false if the last reset was not from the watchdog
+     * or withWatchdogSnapshot() was not used.
      */
-    bool setTrickle(uint8_t diodeAndRout);
+    bool getWatchdogSnapshot(WatchdogSnapshot &snapshot) const;
+
+    static const uint8_t WATCHDOG_PHASE_MAX = 8;                //!< Number of watchdog budget phases
+    static const uint8_t WATCHDOG_PHASE_NETWORK_CONNECT = 0;    //!< Phase for turning on and connecting to the network, from the network_status system event
+    static const uint8_t WATCHDOG_PHASE_CLOUD_CONNECT = 1;      //!< Phase for connecting to the cloud, from the cloud_status system event
+    static const uint8_t WATCHDOG_PHASE_FIRMWARE_UPDATE = 2;    //!< Phase for an OTA firmware update, from the firmware_update system event
+    static const uint8_t WATCHDOG_PHASE_USER = 3;               //!< First phase for application use, such as a flash erase
 
     /**
-     * @brief Returns true if VBAT input is above minimum operating voltage (1.2V)
-     * 
-     * This function will check if trickle charging is enabled first. If enabled, it will be turned off,
-     * the value checked, then turned back on again.
+     * @brief Durations of a watchdog budget phase, see getWatchdogPhaseStats()
      */
-    bool isVBATAboveMin() { bool bResult = false; checkVBAT(REG_ASTAT_BMIN, bResult); return bResult; };
+    typedef struct {
+        uint32_t count;         //!< Number of times the phase ended
+        uint32_t lastMs;        //!< Duration of the last phase in milliseconds
+        uint32_t maxMs;         //!< Longest duration of the phase in milliseconds
+        uint32_t overruns;      //!< Number of times the phase took longer than its budget
+    } WatchdogPhaseStats;
 
     /**
-     * @brief Returns true if VBAT input is above BREF voltage
+     * @brief Start a phase that is allowed to block for longer than the watchdog duration
      * 
-     * The power-up default for BREF is 1.4V (`REG_BREF_CTRL_14_16`), so this provides
-     * some additional margin over the minimum voltage (1.2V). BREF can be changed
-     * to check for higher voltages (fully charged, for example) but it takes several
-     * seconds for the values to settle after making a change, so you don't want to
-     * change it too often.
+     * @param phase Phase, WATCHDOG_PHASE_USER to WATCHDOG_PHASE_MAX - 1 for application phases
      * 
-     * This function will check if trickle charging is enabled first. If enabled, it will be turned off,
-     * the value checked, then turned back on again.
+     * @param budgetMs Maximum duration of the phase in milliseconds
+     * 
+     * @return true on success or false if phase is not valid or an error occurs
+     * 
+     * Until endWatchdogBudget() is called or budgetMs elapses, the watchdog is serviced even if 
+     * AB1805::loop() is not called or a supervisor client is late. With withWatchdogRefreshTimer(), 
+     * budgetMs can be any length. Otherwise the watchdog duration is increased to cover the budget
+     * up to WATCHDOG_MAX_SECONDS, as the loop thread usually can't service it during the phase, and
+     * is restored when the last phase ends. Calling this for a phase that is already active changes 
+     * the budget but not the start time. You'll normally use WatchdogBudgetGuard instead.
      */
-    bool isVBATAboveBREF() { bool bResult = false; checkVBAT(REG_ASTAT_BBOD, bResult); return bResult; };
+    bool beginWatchdogBudget(uint8_t phase, uint32_t budgetMs);
 
     /**
-     * @brief Checks VBAT status
-     * 
-     * @param mask Either REG_ASTAT_BBOD (compare againt BREF) or REG_ASTAT_BMIN (compare against minimum, 1.2V)
+     * @brief End a phase started by beginWatchdogBudget() and record its duration
      * 
-     * @param isAbove True if VBAT is above the specified voltage, or false if not
+     * @param phase Phase passed to beginWatchdogBudget()
      * 
-     * This function will check if trickle charging is enabled first. If enabled, it will be turned off,
-     * the value checked, then turned back on again.
+     * @return true on success or false if an error occurs. Ending a phase that is not active does nothing.
      */
-    bool checkVBAT(uint8_t mask, bool &isAbove);
+    bool endWatchdogBudget(uint8_t phase);
 
     /**
-     * @brief Set the RTC from the system clock
-     * 
-     * This is called automatically from AB1805::loop() when the time is updated from the cloud.
-     * You normally don't need to call this yourself.
+     * @brief Returns true if any phase started by beginWatchdogBudget() is within its budget
      */
-    bool setRtcFromSystem();
+    bool isWatchdogBudgetActive() const;
 
     /**
-     * @brief Sets the RTC from a time_t
+     * @brief Get the durations of a phase since setup() or resetWatchdogPhaseStats()
      * 
-     * @param time The time (in seconds since January 1, 1970, UNIX epoch), UTC.
+     * @param phase Phase passed to beginWatchdogBudget()
      * 
-     * @param lock Lock the I2C bus. Default = true. Pass false if surrounding a block of
-     * related calls with a wire.lock() and wire.unlock() so the block cannot be interrupted
-     * with other I2C operations.
+     * @param stats Filled in with the durations
      * 
-     * This is called automatically from AB1805::loop() when the time is updated from the cloud.
-     * You normally don't need to call this yourself. You might call this if you are also getting
-     * time from an external source like a GPS.
+     * @return true on success or false if phase is not valid
+     * 
+     * The maximum durations can be published to tune the budgets from field data. They are not saved
+     * across a reset. A phase that overruns until the watchdog resets the device never ends, so it 
+     * would not be counted anyway. Use withWatchdogSupervisor() or withBootJournal() to track those resets.
      */
-    bool setRtcFromTime(time_t time, bool lock = true);
+    bool getWatchdogPhaseStats(uint8_t phase, WatchdogPhaseStats &stats) const;
 
     /**
-     * @brief Sets the RTC from a time_t
+     * @brief Clear the durations returned by getWatchdogPhaseStats()
+     */
+    void resetWatchdogPhaseStats();
+
+    /**
+     * @brief Call this before AB1805::setup() to start watchdog budgets automatically from system events
      * 
-     * @param timeptr A struct tm specifying the time. 
+     * @param networkMs Budget for WATCHDOG_PHASE_NETWORK_CONNECT, from powering on or connecting until connected or off, or 0 to disable
      * 
-     * @param lock Lock the I2C bus. Default = true. Pass false if surrounding a block of
-     * related calls with a wire.lock() and wire.unlock() so the block cannot be interrupted
-     * with other I2C operations.
+     * @param cloudMs Budget for WATCHDOG_PHASE_CLOUD_CONNECT, from connecting until connected or disconnected, or 0 to disable
      * 
-     * The following fields are required:
-     * - tm_sec	  seconds after the minute	0-61 (usually 0-59)
-     * - tm_min	  minutes after the hour 0-59
-     * - tm_hour  hours since midnight 0-23
-     * - tm_mday  day of the month 1-31
-     * - tm_mon	  months since January 0-11 (not 1-12!)
-     * - tm_year  years since 1900 (note: 2020 = 120)
-     * - tm_wday  days since Sunday	0-6
+     * @param firmwareUpdateMs Budget for WATCHDOG_PHASE_FIRMWARE_UPDATE, from begin until complete or failed, or 0 to disable
      * 
-     * Note that you must include tm_wday and 0 = Sunday, 1 = Monday, ...
-     * Month of year is 0 - 11, NOT 1 - 12!
-     * Year is years since 1900, so 2020 has 120 in the tm_year field!
+     * @return An AB1805& so you can chain the withXXX() calls, fluent-style.
+     */
+    AB1805 &withSystemWatchdogBudgets(uint32_t networkMs, uint32_t cloudMs, uint32_t firmwareUpdateMs) { 
+        systemWatchdogBudget[WATCHDOG_PHASE_NETWORK_CONNECT] = networkMs;
+        systemWatchdogBudget[WATCHDOG_PHASE_CLOUD_CONNECT] = cloudMs;
+        systemWatchdogBudget[WATCHDOG_PHASE_FIRMWARE_UPDATE] = firmwareUpdateMs;
+        return *this; 
+    };
+
+    /**
+     * @brief Starts a watchdog budget phase and ends it when the object goes out of scope
+     * 
+     * ```
+     * {
+     *     AB1805::WatchdogBudgetGuard guard(ab1805, AB1805::WATCHDOG_PHASE_USER, 300000);
+     *     eraseFlash();
+     * }
+     * ```
+     */
+    class WatchdogBudgetGuard {
+    public:
+        /**
+         * @brief Calls beginWatchdogBudget()
+         */
+        WatchdogBudgetGuard(AB1805 &parent, uint8_t phase, uint32_t budgetMs) : parent(parent), phase(phase) { 
+            parent.beginWatchdogBudget(phase, budgetMs); 
+        };
+
+        /**
+         * @brief Calls endWatchdogBudget()
+         */
+        ~WatchdogBudgetGuard() { parent.endWatchdogBudget(phase); };
+
+        WatchdogBudgetGuard(const WatchdogBudgetGuard&) = delete;
+        WatchdogBudgetGuard &operator=(const WatchdogBudgetGuard&) = delete;
+
+    protected:
+        AB1805 &parent;     //!< The AB1805 object
+        uint8_t phase;      //!< The phase passed to the constructor
+    };
+
+    /**
+     * @brief Stops the watchdog timer. Useful before entering sleep mode.
      * 
-     * This is called automatically from AB1805::loop() when the time is updated from the cloud.
-     * You normally don't need to call this yourself. You might call this if you are also getting
-     * time from an external source like a GPS.
+     * This is done automatically right before reset (using the reset system event)
+     * so the watchdog won't trigger during a firmware update. 
      */
-    bool setRtcFromTm(const struct tm *timeptr, bool lock = true);
+    bool stopWDT() { return setWDT(0); };
 
-    
     /**
-     * @brief Reads a AB1805 register (single byte)
+     * @brief Resumes watchdog with same settings as before
      * 
-     * @param regAddr Register address to read from (0x00 - 0xff)
+     * This is useful after returning from `System.sleep()` in STOP or ULTRA_LOW_POWER
+     * sleep modes where executinon continues. You may also want to call `updateWakeReason()`.
      * 
-     * @param value Filled in with the value from the register
+     * It's safe to call resumeWDT() even if the WDT has never been set, it does nothing
+     * in this case, leaving the watchdog off.
+     */
+    bool resumeWDT() { return setWDT(-1); };
+
+    static const size_t WATCHDOG_CLIENT_MAX = 8;                    //!< Maximum number of clients for withWatchdogSupervisor()
+    static const uint32_t WATCHDOG_SUPERVISOR_MAGIC = 0x41424335;   //!< Magic bytes to detect a valid WatchdogSupervisorState in RTC RAM
+
+    /**
+     * @brief Watchdog supervisor state, saved in the RTC RAM (see withWatchdogSupervisor())
+     */
+    typedef struct {
+        uint32_t magic;                             //!< WATCHDOG_SUPERVISOR_MAGIC
+        uint8_t starvedClient;                      //!< Client id + 1 of the client that stopped the watchdog refresh, or 0
+        uint8_t reserved[3];                        //!< Reserved, currently 0
+        uint16_t misses[WATCHDOG_CLIENT_MAX];       //!< Number of times each client missed its deadline
+    } WatchdogSupervisorState;
+
+    static const size_t WATCHDOG_SUPERVISOR_RAM_SIZE = sizeof(WatchdogSupervisorState); //!< Bytes of RTC RAM used by withWatchdogSupervisor()
+
+    /**
+     * @brief Call this before AB1805::setup() to refresh the watchdog only when all clients are healthy
      * 
-     * @param lock Lock the I2C bus. Default = true. Pass false if surrounding a block of
-     * related calls with a wire.lock() and wire.unlock() so the block cannot be interrupted
-     * with other I2C operations.
+     * @param ramAddr Address in the RTC RAM to save the miss counters. WATCHDOG_SUPERVISOR_RAM_SIZE (24) 
+     * bytes are used starting at this address.
      * 
-     * @return true on success or false on error
+     * @return An AB1805& so you can chain the withXXX() calls, fluent-style.
      * 
-     * There is also an overload that returns value instead of passing it by reference.
+     * Each task, such as a worker thread, registers with addWatchdogClient() and calls 
+     * watchdogHeartbeat() more often than its deadline. AB1805::loop() only refreshes the
+     * watchdog set with setWDT() when every client has a heartbeat within its deadline. When a 
+     * client misses its deadline, its miss counter and the client id are saved in the RTC RAM
+     * before the watchdog resets the device, and getWatchdogStarvedClient() returns the id after
+     * the reset. If the loop thread itself stops, there's no client id.
      */
-    bool readRegister(uint8_t regAddr, uint8_t &value, bool lock = true);
+    AB1805 &withWatchdogSupervisor(size_t ramAddr) { supervisorEnabled = true; supervisorRamAddr = ramAddr; return *this; };
 
     /**
-     * @brief Reads a AB1805 register (single byte) and returns it
+     * @brief Register a client of the watchdog supervisor
      * 
-     * @param regAddr Register address to read from (0x00 - 0xff)
+     * @param id Client id, 0 to WATCHDOG_CLIENT_MAX - 1. Use the same id for the same task on every boot 
+     * so the miss counters in RTC RAM refer to the same task.
      * 
-     * @param lock Lock the I2C bus. Default = true. Pass false if surrounding a block of
-     * related calls with a wire.lock() and wire.unlock() so the block cannot be interrupted
-     * with other I2C operations.
+     * @param deadlineMs Maximum time between calls to watchdogHeartbeat() in milliseconds
      * 
-     * @return The value of the register or 0x00 if it could not be read.
+     * @return true on success or false if id is not valid
      * 
-     * There is an overload that takes a uint8_t &value parameter which is generally
-     * better because you can tell the difference between a value of 0 and a failure
-     * (false is returned).
+     * The client starts out healthy, as if watchdogHeartbeat() was just called. Requires withWatchdogSupervisor().
      */
-    uint8_t readRegister(uint8_t regAddr, bool lock = true);
+    bool addWatchdogClient(uint8_t id, uint32_t deadlineMs);
 
     /**
-     * @brief Reads sequential registers
+     * @brief Remove a client of the watchdog supervisor, such as when a task exits normally
      * 
-     * @param regAddr Register address to start reading from (0x00 - 0xff) 
-     * 
-     * @param array Array of uint8_t values, filled in by this call
+     * @param id Client id passed to addWatchdogClient()
+     */
+    void removeWatchdogClient(uint8_t id);
+
+    /**
+     * @brief Report that a client is healthy
      * 
-     * @param num Number of registers to read
+     * @param id Client id passed to addWatchdogClient()
      * 
-     * @param lock Lock the I2C bus. Default = true. Pass false if surrounding a block of
-     * related calls with a wire.lock() and wire.unlock() so the block cannot be interrupted
-     * with other I2C operations.
+     * This only saves millis() and can be called from any thread.
+     */
+    void watchdogHeartbeat(uint8_t id);
+
+    /**
+     * @brief Get the client that stopped the watchdog refresh before the last reset
      * 
-     * Reads a number of registers at once. This is done when reading the RTC value so
-     * it's atomic (counters will not be incremented in the middle of a read). Also used
-     * for reading the device RAM.
+     * @return The client id, or -1 if there was none. This is set when the wake reason is
+     * `WATCHDOG` and a client missed its deadline.
+     */
+    int getWatchdogStarvedClient() const { return watchdogStarvedClient; };
+
+    /**
+     * @brief Get the number of times a client has missed its deadline, saved in the RTC RAM
      * 
-     * Do not read past address 0xff. 
+     * @param id Client id passed to addWatchdogClient()
      */
-    bool readRegisters(uint8_t regAddr, uint8_t *array, size_t num, bool lock = true);
+    uint16_t getWatchdogClientMisses(uint8_t id) const { return (id < WATCHDOG_CLIENT_MAX) ? supervisorState.misses[id] : 0; };
 
+    /**
+     * @brief Clear the miss counters in the RTC RAM
+     */
+    bool resetWatchdogClientMisses();
 
     /**
-     * @brief Writes a AB1805 register (single byte)
+     * @brief Returns true if all watchdog supervisor clients are within their deadline
      * 
-     * @param regAddr Register address to write to (0x00 - 0xff)
+     * When a client has missed its deadline for the first time since its last heartbeat, its 
+     * miss counter is incremented and saved in the RTC RAM. This is called from AB1805::loop()
+     * before refreshing the watchdog.
+     */
+    bool checkWatchdogClients();
+
+    static const size_t WATCHDOG_THREAD_STACK_SIZE = 3072;  //!< Stack size of the thread used by withWatchdogSnapshot()
+    static const unsigned long WATCHDOG_THREAD_PERIOD_MS = 100; //!< How often the withWatchdogSnapshot() thread checks for work
+
+    /**
+     * @brief Get the time from the RTC as a time_t
      * 
-     * @param value This value is written to the register
+     * @param time Filled in with the number of second since January 1, 1970 UTC.
      * 
-     * @param lock Lock the I2C bus. Default = true. Pass false if surrounding a block of
-     * related calls with a wire.lock() and wire.unlock() so the block cannot be interrupted
-     * with other I2C operations.
+     * @return true on success or false if an error occurs.
      * 
-     * @return true on success or false on error
+     * The time value is basically the same as what would be returned from `Time.now()`
+     * except it's retrieved from the AB1805 RTC instead of the system. However both
+     * should approximately equal to each other.
      */
-    bool writeRegister(uint8_t regAddr, uint8_t value, bool lock = true);
+    bool getRtcAsTime(time_t &time);
 
     /**
-     * @brief Writes sequential AB1805 registers
-     * 
-     * @param regAddr Register address to start writing to (0x00 - 0xff)
-     * 
-     * @param array Array of uint8_t values to write
+     * @brief Get the time from the RTC as a time_t, and the status register
      * 
-     * @param num Number of registers to write
+     * @param time Filled in with the number of second since January 1, 1970 UTC.
      * 
-     * @param lock Lock the I2C bus. Default = true. Pass false if surrounding a block of
-     * related calls with a wire.lock() and wire.unlock() so the block cannot be interrupted
-     * with other I2C operations.
+     * @param status Filled in with the value of REG_STATUS (REG_STATUS_ALM, REG_STATUS_TIM, etc.)
+     * at the time the time was read.
      * 
-     * @return true on success or false on error
+     * @return true on success or false if an error occurs or the RTC has not been set.
      * 
-     * Do not write past address 0xff. 
+     * This is a single I2C transaction. It's useful if you are polling for alarm or
+     * timer events and also need the time. The status flags are not cleared.
      */
-    bool writeRegisters(uint8_t regAddr, const uint8_t *array, size_t num, bool lock = true);
+    bool getRtcAsTime(time_t &time, uint8_t &status);
 
     /**
-     * @brief Writes a AB1805 register (single byte) with masking of existing value
+     * @brief Get the time from the RTC in milliseconds, with 10 millisecond resolution
      * 
-     * @param regAddr Register address to read from and write to (0x00 - 0xff)
+     * @param ms Filled in with the number of milliseconds since January 1, 1970 UTC.
      * 
-     * @param andValue The existing register values is logically ANDed with this value
+     * @return true on success or false if an error occurs or the RTC has not been set.
      * 
-     * @param orValue This value is logically ORed with this value before storing
+     * The RTC keeps hundredths of a second in REG_HUNDREDTH when running from the XT
+     * crystal oscillator. When using the RC oscillator, the fractional part is always 0.
      * 
-     * @param lock Lock the I2C bus. Default = true. Pass false if surrounding a block of
-     * related calls with a wire.lock() and wire.unlock() so the block cannot be interrupted
-     * with other I2C operations.
+     * This is a single I2C transaction.
+     */
+    bool getRtcAsMillis(uint64_t &ms);
+
+    /**
+     * @brief Get the time from the RTC in milliseconds, and the status register
      * 
-     * @return true on success or false on error
+     * @param ms Filled in with the number of milliseconds since January 1, 1970 UTC.
      * 
-     * If lock is true then the lock surrounds both the read and write, so the operation is
-     * atomic.
+     * @param status Filled in with the value of REG_STATUS (REG_STATUS_ALM, REG_STATUS_TIM, etc.)
+     * at the time the time was read.
      * 
-     * If the value is unchanged after the andValue and orValue is applied, the write is skipped.
-     * The read is always done.
+     * @return true on success or false if an error occurs or the RTC has not been set.
      */
-    bool maskRegister(uint8_t regAddr, uint8_t andValue, uint8_t orValue, bool lock = true);
+    bool getRtcAsMillis(uint64_t &ms, uint8_t &status);
 
     /**
-     * @brief Returns true if a bit in a register is 0
-     * 
-     * @param regAddr Register address to read from (0x00 - 0xff)
-     * 
-     * @param bitMask Mask to check. Note that the bitMask should have a 1 bit where you are checking
-     * for a 0 bit! Normally there is only one bit set in bitMask.
+     * @brief Get the time from the RTC as a struct timespec, with 10 millisecond resolution
      * 
-     * @param lock Lock the I2C bus. Default = true. Pass false if surrounding a block of
-     * related calls with a wire.lock() and wire.unlock() so the block cannot be interrupted
-     * with other I2C operations.
+     * @param ts Filled in with the seconds since January 1, 1970 UTC (tv_sec) and the 
+     * fractional part of the second in nanoseconds (tv_nsec), a multiple of 10000000.
      * 
-     * @return true if the register could be read and the bit is 0, otherwise false.
+     * @return true on success or false if an error occurs or the RTC has not been set.
      */
-    bool isBitClear(uint8_t regAddr, uint8_t bitMask, bool lock = true);
+    bool getRtcAsTimespec(struct timespec &ts);
 
     /**
-     * @brief Returns true if a bit in a register is 1
+     * @brief Enable the cached RTC clock, used by getCachedRtcAsMillis() and getCachedRtcAsTime()
      * 
-     * @param regAddr Register address to read from (0x00 - 0xff)
+     * @param resyncPeriodMs How often to read the RTC from AB1805::loop(), in milliseconds. Default: 60000 (1 minute).
      * 
-     * @param bitMask Mask to check. The bitMask should have a 1 bit where you are checking
-     * for a 1 bit. Normally there is only one bit set in bitMask.
+     * @param maxErrorMs Also read the RTC from loop() if the estimated error exceeds this value. Default: 50.
      * 
-     * @param lock Lock the I2C bus. Default = true. Pass false if surrounding a block of
-     * related calls with a wire.lock() and wire.unlock() so the block cannot be interrupted
-     * with other I2C operations.
+     * @param clockPpm The accuracy of the MCU millis() clock in parts per million, used to
+     * estimate the error. Default: 250.
      * 
-     * @return true if the register could be read and the bit is 1, otherwise false.
+     * @return An AB1805& so you can chain the withXXX() calls, fluent-style.
+     * 
+     * When enabled, the RTC is read in a single I2C transaction and the value of millis()
+     * at that moment is saved. The cached functions then add the elapsed millis() without
+     * accessing the I2C bus. The estimated error is 10 ms (the resolution of REG_HUNDREDTH)
+     * plus clockPpm of the time since the last read.
      */
-    bool isBitSet(uint8_t regAddr, uint8_t bitMask, bool lock = true);
+    AB1805 &withCachedClock(unsigned long resyncPeriodMs = 60000, unsigned long maxErrorMs = 50, uint32_t clockPpm = 250) { 
+        cachedClockEnabled = true; cachedClockResyncPeriod = resyncPeriodMs; cachedClockMaxError = maxErrorMs; cachedClockPpm = clockPpm; return *this; 
+    };
 
     /**
-     * @brief Clear a bit in a register
-     * 
-     * @param regAddr The address of the register to read/write
+     * @brief Get the time in milliseconds from the cached RTC clock
      * 
-     * @param bitMask The bit mask to clear. This has a 1 bit in the bit you want to clear, and will typically
-     * only have one bit set, though you can clear multiple bits at the same time with this function.
+     * @param ms Filled in with the number of milliseconds since January 1, 1970 UTC.
      * 
-     * @param lock Whether to lock the I2C bus, the default is true. You pass false if you are grouping
-     * together functions in a single lock, for example doing a read/modify/write cycle.
+     * @return true on success or false if the RTC has not been set or could not be read.
      * 
-     * The bit is cleared only if set. If the bit(s) are already cleared, then only the read is done,
-     * and the write is skipped. A read is always done. 
+     * If the cached clock is not enabled using withCachedClock(), this is the same as getRtcAsMillis()
+     * and reads the RTC every time.
      * 
-     * If lock is true, then the lock surround both the read and write so the entire operation is atomic.
+     * Otherwise it reads the RTC when the resync period has elapsed or the estimated error exceeds 
+     * maxErrorMs (normally done from AB1805::loop() first), and at most once per second while the RTC
+     * has not been set. At other times, it does not access the I2C bus. It can be called from any thread,
+     * but not from an ISR, as reading the RTC locks the I2C bus.
      */
-    bool clearRegisterBit(uint8_t regAddr, uint8_t bitMask, bool lock = true);
+    bool getCachedRtcAsMillis(uint64_t &ms);
 
     /**
-     * @brief Sets a bit in a register
-     * 
-     * @param regAddr The address of the register to read/write
+     * @brief Get the time as a time_t from the cached RTC clock
      * 
-     * @param bitMask The bit mask to set. This has a 1 bit in the bit you want to set, and will typically
-     * only have one bit set, though you can set multiple bits at the same time with this function.
+     * @param time Filled in with the number of second since January 1, 1970 UTC.
      * 
-     * @param lock Whether to lock the I2C bus, the default is true. You pass false if you are grouping
-     * together functions in a single lock, for example doing a read/modify/write cycle.
+     * @return true on success or false if the RTC has not been set or could not be read.
      * 
-     * The bit is set only if cleared (0). If the bit(s) are already set, then only the read is done,
-     * and the write is skipped. A read is always done.
+     * See getCachedRtcAsMillis().
+     */
+    bool getCachedRtcAsTime(time_t &time);
+
+    /**
+     * @brief Read the RTC and update the cached RTC clock now
      * 
-     * If lock is true, then the lock surround both the read and write so the entire operation is atomic.
+     * This is done automatically from AB1805::loop() so you don't normally need to call it.
      */
-    bool setRegisterBit(uint8_t regAddr, uint8_t bitMask, bool lock = true);
+    bool syncCachedClock();
 
-	/**
-	 * @brief Returns the length of the RTC RAM in bytes (always 256)
-	 */
-	inline size_t length() { return 256; }
+    /**
+     * @brief Returns the estimated error of the cached RTC clock in milliseconds
+     */
+    unsigned long getCachedClockErrorMs() const;
 
-	/**
-	 * @brief Erases the RTC RAM to 0x00 values
-     * 
-     * @param lock Whether to lock the I2C bus, the default is true. You pass false if you are grouping
-     * together functions in a single lock, for example doing a read/modify/write cycle.
-	 */
-	bool eraseRam(bool lock = true);
+    /**
+     * @brief Returns true if the cached RTC clock should be read again, from the resync period, maximum error, 
+     * or once per second while the RTC is not set
+     */
+    bool cachedClockNeedsSync() const;
 
-	/**
-	 * @brief Read from RTC RAM using EEPROM-style API
-	 *
-	 * @param ramAddr The address in the RTC RAM to read from
-     * 
-	 * @param t The variable to read to. This must be a simple type (bool, int, float, etc.)
-     * or struct. It cannot save a c-string (const char *), String, or other class. You
-     * typically cannot get any pointers or structs containing pointers.
-	 */
-    template <typename T> T &get(size_t ramAddr, T &t) {
-        readRam(ramAddr, (uint8_t *)&t, sizeof(T));
-        return t;
-    }
+    static const size_t CALIBRATION_MAX_SAMPLES = 4;            //!< Number of drift samples kept in the calibration state
+    static const size_t CALIBRATION_MIN_SAMPLES = 3;            //!< Samples required before the calibration is changed
+    static const uint32_t CALIBRATION_MIN_INTERVAL = 3600;      //!< Minimum seconds between samples, closer samples are ignored
+    static const uint32_t CALIBRATION_MAGIC = 0x41424331;       //!< Magic bytes to detect valid calibration state in RTC RAM
+    static constexpr float XT_CAL_PPM_PER_STEP = 1.90735f;      //!< XT calibration adjustment per step of OFFSETX in ppm
 
-	/**
-	 * @brief Write from RTC RAM using EEPROM-style API
-	 *
-	 * @param ramAddr The address in the RTC RAM to write to
-     * 
-	 * @param t The variable to write from. t is not modified. This must be a simple type (bool, int, float, etc.)
-     * or struct. It cannot save a c-string (const char *), String, or other class. You
-     * typically cannot save any pointers or structs containing pointers.
-	 */
-    template <typename T> const T &put(size_t ramAddr, const T &t) {
-        writeRam(ramAddr, (const uint8_t *)&t, sizeof(T));
-        return t;
-    }
+    /**
+     * @brief One drift measurement
+     */
+    typedef struct {
+        uint32_t elapsed;       //!< Reference time of this sample, seconds after CalibrationState::baseTime
+        int32_t offsetMs;       //!< RTC minus reference time in milliseconds, plus CalibrationState::correctionMs
+    } CalibrationSample;
 
     /**
-     * @brief Low-level read call
-     *
-	 * @param ramAddr The address in the RTC RAM to read from
-	 *
-	 * @param data The buffer to read into
-	 *
-	 * @param dataLen The number of bytes to read
-	 *
-     * @param lock Whether to lock the I2C bus, the default is true. You pass false if you are grouping
-     * together functions in a single lock, for example doing a read/modify/write cycle.
-     * 
-	 * The dataLen can be larger than the maximum I2C read. Multiple reads will be done if necessary.
-     * However do not read past the end of RAM (address 255).
+     * @brief Calibration state, saved in the RTC RAM (see withCalibration())
      */
-	virtual bool readRam(size_t ramAddr, uint8_t *data, size_t dataLen, bool lock = true);
+    typedef struct {
+        uint32_t magic;         //!< CALIBRATION_MAGIC
+        int16_t adj;            //!< Programmed adjustment in steps of XT_CAL_PPM_PER_STEP, positive makes the RTC faster
+        uint8_t numSamples;     //!< Number of valid entries in samples
+        uint8_t reserved;       //!< Reserved, currently 0
+        uint32_t baseTime;      //!< Reference time of the first sample (seconds since January 1, 1970 UTC)
+        int32_t correctionMs;   //!< Added to the measured offset to remove the steps when the RTC was set
+        CalibrationSample samples[CALIBRATION_MAX_SAMPLES]; //!< Samples, oldest first
+    } CalibrationState;
+
+    static const size_t CALIBRATION_RAM_SIZE = sizeof(CalibrationState); //!< Bytes of RTC RAM used by withCalibration()
 
     /**
-     * @brief Low-level write call
+     * @brief Call this before AB1805::setup() to calibrate the XT oscillator from cloud time syncs
      *
-	 * @param ramAddr The address in the RTC RAM to write to
-	 *
+     * @param ramAddr Address in the RTC RAM to save the calibration state. CALIBRATION_RAM_SIZE (48)
+     * bytes are used starting at this address.
+     *
+     * @param minSpanSecs Minimum time between the first and last sample before the calibration
+     * is changed, in seconds. Default: 172800 (2 days).
+     *
+     * @param minErrorPpm The calibration is only changed if the measured drift is at least this
+     * many ppm. Default: 2.0.
+     *
+     * @return An AB1805& so you can chain the withXXX() calls, fluent-style.
+     *
+     * Each time the time is synchronized from the cloud, AB1805::loop() compares the RTC with
+     * the cloud time before the RTC is set from it, and saves the offset in the RTC RAM so
+     * samples are kept across sleep and reset. Steps caused by setting the RTC are subtracted
+     * out. When there are at least CALIBRATION_MIN_SAMPLES samples spanning minSpanSecs the
+     * drift is found by linear regression and REG_CAL_XT and the XTCAL bits in REG_OSC_STATUS
+     * are updated using setXtCalibration().
+     *
+     * Cloud time only has 1 second resolution, so the span needs to be long. At 2 days, 1 second
+     * of error is about 6 ppm, and the regression over several samples reduces this.
+     */
+    AB1805 &withCalibration(size_t ramAddr, uint32_t minSpanSecs = 172800, float minErrorPpm = 2.0) {
+        calibrationEnabled = true; calibrationRamAddr = ramAddr; calibrationMinSpan = minSpanSecs; calibrationMinErrorPpm = minErrorPpm; return *this;
+    };
+
+    /**
+     * @brief Add a drift sample comparing the RTC to a reference time
+     *
+     * @param refTime The reference time in seconds since January 1, 1970 UTC
+     *
+     * @param refMillis The value of millis() when refTime was obtained
+     *
+     * @return true on success or false if the RTC could not be read or calibrated.
+     *
+     * This is called from AB1805::loop() when the time is synchronized from the cloud if
+     * withCalibration() is used. You can also call it with another reference such as GPS.
+     * It must be called before the RTC is set from the reference time.
+     */
+    bool updateCalibration(time_t refTime, unsigned long refMillis);
+
+    /**
+     * @brief Discard the calibration samples
+     *
+     * @param clearAdjustment Also set the XT calibration back to 0. Default: false.
+     */
+    bool resetCalibration(bool clearAdjustment = false);
+
+    /**
+     * @brief Get the calibration state (see withCalibration())
+     */
+    const CalibrationState &getCalibrationState() const { return calibrationState; };
+
+    /**
+     * @brief Returns the XT calibration adjustment programmed by the calibration engine in ppm
+     *
+     * Positive values make the RTC run faster.
+     */
+    float getCalibrationPpm() const { return calibrationState.adj * XT_CAL_PPM_PER_STEP; };
+
+    /**
+     * @brief Program the XT oscillator calibration
+     *
+     * @param adj The adjustment in steps of XT_CAL_PPM_PER_STEP (1.90735 ppm), -320 to 127.
+     * Positive values make the RTC run faster.
+     *
+     * @param lock Lock the I2C bus. Default = true. Pass false if surrounding a block of
+     * related calls with a wire.lock() and wire.unlock() so the block cannot be interrupted
+     * with other I2C operations.
+     *
+     * @return true on success or false if an error occurs or adj is out of range.
+     *
+     * Writes REG_CAL_XT and the XTCAL bits in REG_OSC_STATUS. This does not change the
+     * calibration state used by withCalibration().
+     */
+    bool setXtCalibration(int adj, bool lock = true);
+
+    /**
+     * @brief Converts an XT calibration adjustment to register values
+     *
+     * @param adj The adjustment in steps of XT_CAL_PPM_PER_STEP (1.90735 ppm), -320 to 127.
+     *
+     * @param calXt Filled in with the value for REG_CAL_XT (CMDX and OFFSETX)
+     *
+     * @param xtcal Filled in with the XTCAL value (0 - 3), not shifted
+     *
+     * @return true on success or false if adj is out of range.
+     *
+     * This is the procedure in the AB18X5 datasheet, where adj = PAdj / 1.90735.
+     */
+    static bool xtCalibrationRegisters(int adj, uint8_t &calXt, uint8_t &xtcal);
+
+    /**
+     * @brief Get the time from the RTC as a struct tm
+     * 
+     * @param timeptr pointer to struct tm. Filled in with the current time, UTC.
+     * 
+     * @return true on success or false if an error occurs.
+     * 
+     * The fields of the timeptr are:
+     * - tm_sec	  seconds after the minute	0-61 (usually 0-59)
+     * - tm_min	  minutes after the hour 0-59
+     * - tm_hour  hours since midnight 0-23
+     * - tm_mday  day of the month 1-31
+     * - tm_mon	  months since January 0-11 (not 1-12!)
+     * - tm_year  years since 1900 (note: 2020 = 120)
+     * - tm_wday  days since Sunday	0-6
+     */
+    bool getRtcAsTm(struct tm *timeptr);
+
+    /**
+     * @brief Get the time from the RTC as a struct tm, and the status register
+     * 
+     * @param timeptr pointer to struct tm. Filled in with the current time, UTC.
+     * 
+     * @param status Filled in with the value of REG_STATUS (REG_STATUS_ALM, REG_STATUS_TIM, etc.)
+     * at the time the time was read.
+     * 
+     * @return true on success or false if an error occurs or the RTC has not been set.
+     * 
+     * The time registers, alarm registers, status register, and control 1 register (for
+     * the WRTC bit that indicates that the RTC has been set) are read using a single
+     * I2C transaction. The status flags are not cleared.
+     */
+    bool getRtcAsTm(struct tm *timeptr, uint8_t &status);
+
+    /**
+     * @brief Reads registers 0x00 - 0x10 in a single I2C transaction
+     * 
+     * @param array Array of TIME_BLOCK_SIZE (17) bytes, filled in by this call. Index the
+     * array by register address, for example `array[REG_STATUS]`.
+     * 
+     * @param lock Lock the I2C bus. Default = true. Pass false if surrounding a block of
+     * related calls with a wire.lock() and wire.unlock() so the block cannot be interrupted
+     * with other I2C operations.
+     * 
+     * @return true on success or false on error
+     * 
+     * This includes the time (hundredths through weekday), the alarm, REG_STATUS,
+     * and REG_CTRL_1.
+     */
+    bool readTimeBlock(uint8_t *array, bool lock = true);
+
+    /**
+     * @brief Reads the time block (registers 0x00 - 0x10) and checks that the RTC has been set
+     * 
+     * @param array Array of TIME_BLOCK_SIZE (17) bytes, filled in by this call.
+     * 
+     * @param status Filled in with the value of REG_STATUS
+     * 
+     * @param lock Lock the I2C bus. Default = true.
+     * 
+     * @return true if the registers were read and WRTC is 0 (RTC has been set), false otherwise.
+     */
+    bool readRtcRegisters(uint8_t *array, uint8_t &status, bool lock = true);
+
+    /**
+     * @brief Resets the configuration of the AB1805 to default settings
+     * 
+     * @param flags flags to customize reset behavior (default: 0)
+     * 
+     * @return true on success or false if an error occurs.
+     * 
+     * - `AB1805::RESET_PRESERVE_REPEATING_TIMER` keeps repeating timers programmed when resetting configuration.
+     * - `AB1805::RESET_DISABLE_XT` selects the RC oscillator instead of the XT crystal oscillator.
+     * 
+     * The default register values are written using burst writes of contiguous registers, 
+     * except that each key-protected register is written separately after its own REG_CONFIG_KEY write.
+     */
+    bool resetConfig(uint32_t flags = 0);
+
+    /**
+     * @brief Set an interrupt at a time in the future using a time_t
+     * 
+     * @param time The number of second after January 1, 1970 UTC. 
+     * 
+     * @return true on success or false if an error occurs.
+     * 
+     * This causes an interrupt on FOUT/nIRQ in the future. It will execute
+     * once. This can only be done if the RTC has been programmed with
+     * the current time, which it normally gets from the cloud at startup.
+     * 
+     * There can only be one interrupt set. Setting at one-time or repeating interrupt
+     * removes any previously set interrupt time.
+     */
+    bool interruptAtTime(time_t time);
+
+    /**
+     * @brief Set an interrupt at a time in the future using a struct tm *.
+     * 
+     * @param timeptr pointer to struct tm. This specifies the time (UTC).
+     * 
+     * @return true on success or false if an error occurs.
+     * 
+     * This causes an interrupt on FOUT/nIRQ in the future. It will execute
+     * once. This can only be done if the RTC has been programmed with
+     * the current time, which it normally gets from the cloud at startup.
+     * 
+     * Only the tm_sec, tm_min, tm_hour, tm_mday, tm_mon, and tm_year are 
+     * used. The tm_wday field is ignored. Note that tm_mon is 0-11, not 1-12.
+     * 
+     * There can only be one interrupt set. Setting at one-time or repeating interrupt
+     * removes any previously set interrupt time.
+     * 
+     * The fields of the timeptr are:
+     * - tm_sec	  seconds after the minute	0-61 (usually 0-59)
+     * - tm_min	  minutes after the hour 0-59
+     * - tm_hour  hours since midnight 0-23
+     * - tm_mday  day of the month 1-31
+     * - tm_mon	  months since January 0-11 (not 1-12!)
+     * - tm_year  years since 1900 (note: 2020 = 120)
+     * - tm_wday  days since Sunday	0-6
+     */
+    bool interruptAtTm(struct tm *timeptr);
+
+    /**
+     * @brief Set a repeating interrupt
+     * 
+     * @param timeptr pointer to struct tm. This specifies the time (UTC).
+     * 
+     * @param rptValue a constant for which fields of timeptr are used.
+     * 
+     * @param hundredths Value for the hundredths alarm register (REG_HUNDREDTH_ALARM). The default
+     * is 0x00 (on the second). This is BCD, or one of the special values for `REG_TIMER_CTRL_RPT_HUN`;
+     * see hundredthsAlarmValue().
+     * 
+     * @return true on success or false if an error occurs.
+     * 
+     * This causes an interrupt on FOUT/nIRQ in the future, repeating.
+     * This can only be done if the RTC has been programmed with
+     * the current time, which it normally gets from the cloud at startup.
+     * 
+     * - `REG_TIMER_CTRL_RPT_HUN` hundredths matches, timeptr is not used and can be NULL (see repeatingInterruptSubSecond())
+     * - `REG_TIMER_CTRL_RPT_SEC` tm_sec matches (once per minute)
+     * - `REG_TIMER_CTRL_RPT_MIN` tm_sec, tm_min match (once per hour)
+     * - `REG_TIMER_CTRL_RPT_HOUR` tm_sec, tm_min, tm_hour match (once per day)
+     * - `REG_TIMER_CTRL_RPT_WKDY` tm_sec, tm_min, tm_hour, tm_wday match (once per week)
+     * - `REG_TIMER_CTRL_RPT_DATE` tm_sec, tm_min, tm_hour, tm_mday match (once per month)
+     * - `REG_TIMER_CTRL_RPT_MON` tm_sec, tm_min, tm_hour, tm_mday, tm_mon match (once per year)
+     * 
+     * Note that tm_mon (month) is 0 - 11, not 1 - 12! 
+     * 
+     * There can only be one interrupt set. Setting at one-time or repeating interrupt
+     * removes any previously set interrupt time.
+     * 
+     * If you reset the AB1805 configuration using `resetConfig()`, the repeating timer
+     * will be cleared, unless you add the `AB1805::RESET_PRESERVE_REPEATING_TIMER` parameter 
+     * to preserve it.
+     * 
+     * The fields of the timeptr are:
+     * - tm_sec	  seconds after the minute	0-61 (usually 0-59)
+     * - tm_min	  minutes after the hour 0-59
+     * - tm_hour  hours since midnight 0-23
+     * - tm_mday  day of the month 1-31
+     * - tm_mon	  months since January 0-11 (not 1-12!)
+     * - tm_year  years since 1900 (note: 2020 = 120)
+     * - tm_wday  days since Sunday	0-6
+     */
+    bool repeatingInterrupt(struct tm *timeptr, uint8_t rptValue, uint8_t hundredths = 0x00);
+
+    /**
+     * @brief Sub-second repeat modes for repeatingInterruptSubSecond()
+     */
+    enum class SubSecondRepeat {
+        SECOND,             //!< Once per second, when the hundredths match
+        TENTH,              //!< Once per tenth of a second, when the hundredths digit matches
+        HUNDREDTH           //!< Every hundredth of a second
+    };
+
+    /**
+     * @brief Set a repeating interrupt more often than once per minute, using the hundredths alarm
+     * 
+     * @param rpt `SubSecondRepeat::SECOND`, `SubSecondRepeat::TENTH`, or `SubSecondRepeat::HUNDREDTH`
+     * 
+     * @param offsetMs Milliseconds after the second (SECOND) or after the tenth of a second (TENTH)
+     * to interrupt. The resolution is 10 milliseconds. Not used for HUNDREDTH.
+     * 
+     * @return true on success or false if an error occurs.
+     * 
+     * For example, to keep devices sharing a radio channel from transmitting at the same time, 
+     * each device can use a different offsetMs derived from its device ID with SECOND.
+     * 
+     * This uses `REG_TIMER_CTRL_RPT_HUN`, so the other alarm registers are ignored and this works
+     * even if the RTC has not been set. As with repeatingInterrupt(), this disables the watchdog
+     * and replaces any previously set interrupt time.
+     */
+    bool repeatingInterruptSubSecond(SubSecondRepeat rpt, uint16_t offsetMs = 0);
+
+    /**
+     * @brief Set an interrupt at a time with millisecond resolution
+     * 
+     * @param ms Milliseconds since January 1, 1970 UTC. The alarm resolution is 10 milliseconds,
+     * so this is rounded to the nearest hundredth of a second.
+     * 
+     * @return true on success or false if an error occurs.
+     * 
+     * This is like interruptAtTime() but also sets the hundredths alarm.
+     */
+    bool interruptAtMillis(uint64_t ms);
+
+    /**
+     * @brief Get the REG_HUNDREDTH_ALARM value for a sub-second repeat mode
+     * 
+     * @param rpt The repeat mode
+     * 
+     * @param offsetMs Milliseconds after the second (SECOND) or tenth of a second (TENTH)
+     * 
+     * @return The register value. The datasheet uses 0xF0 - 0xF9 (tenths digit F) to match only the
+     * hundredths digit, and 0xFF to match every hundredth, when the repeat is `REG_TIMER_CTRL_RPT_HUN`.
+     */
+    static constexpr uint8_t hundredthsAlarmValue(SubSecondRepeat rpt, uint16_t offsetMs) {
+        return (rpt == SubSecondRepeat::HUNDREDTH) ? HUNDREDTH_ALARM_EVERY :
+            (rpt == SubSecondRepeat::TENTH) ? (uint8_t)(HUNDREDTH_ALARM_TENTH | ((offsetMs % 100) / 10)) :
+            valueToBcd((offsetMs % 1000) / 10);
+    }
+
+    static const uint8_t HUNDREDTH_ALARM_TENTH = 0xf0;    //!< REG_HUNDREDTH_ALARM tenths digit to match once per tenth of a second
+    static const uint8_t HUNDREDTH_ALARM_EVERY = 0xff;    //!< REG_HUNDREDTH_ALARM value to match every hundredth of a second
+
+    /**
+     * @brief Clear repeating interrupt set with `repeatingInterrupt()`.
+
+     * @return true on success or false if an error occurs.
+     */
+    bool clearRepeatingInterrupt();
+
+    static const size_t ALARM_TIMER_MAX = 12;                   //!< Maximum number of timers for withAlarmTimers()
+    static const uint32_t ALARM_TIMER_MAGIC = 0x41424333;       //!< Magic bytes to detect a valid timer queue in RTC RAM
+    static const uint32_t ALARM_TIMER_MAX_PERIOD = 0xffffff;    //!< Maximum period for setAlarmTimer() in seconds (about 194 days)
+
+    /**
+     * @brief One timer in the queue used by withAlarmTimers()
+     */
+    typedef struct {
+        uint32_t deadline;      //!< Time the timer expires, seconds since January 1, 1970 UTC
+        uint32_t periodAndId;   //!< Period in seconds in the upper 24 bits (0 = one-shot), id in the lower 8 bits
+        uint32_t slack;         //!< Seconds after deadline the timer can be delayed to share a wake with other timers
+    } AlarmTimer;
+
+    /**
+     * @brief Statistics for the timers used by withAlarmTimers(), saved in the RTC RAM
+     */
+    typedef struct {
+        uint32_t startTime;     //!< Time the statistics were started, seconds since January 1, 1970 UTC
+        uint32_t wakes;         //!< Number of RTC alarm wakes (ALM event or boot) where serviceAlarmTimers() found expired timers
+        uint32_t timersFired;   //!< Number of expired timers run on those wakes. timersFired - wakes is the number of wakes saved.
+        uint32_t awakeMs;       //!< Milliseconds the device has been awake since startTime, across resets
+    } AlarmTimerStats;
+
+    /**
+     * @brief Timer queue used by withAlarmTimers(), saved in the RTC RAM
+     */
+    typedef struct {
+        uint32_t magic;         //!< ALARM_TIMER_MAGIC
+        uint8_t numTimers;      //!< Number of valid entries in timers
+        uint8_t reserved[3];    //!< Reserved, currently 0
+        AlarmTimerStats stats;  //!< Statistics
+        AlarmTimer timers[ALARM_TIMER_MAX]; //!< Binary min-heap ordered by deadline, timers[0] is the next to expire
+    } AlarmTimerQueue;
+
+    static const size_t ALARM_TIMER_RAM_SIZE = sizeof(AlarmTimerQueue); //!< Bytes of RTC RAM used by withAlarmTimers()
+
+    /**
+     * @brief Function called from AB1805::loop() when a timer set with setAlarmTimer() expires
+     * 
+     * The parameter is the id that was passed to setAlarmTimer(). Ids are used instead of a 
+     * function per timer so timers can be saved in the RTC RAM and still be dispatched after
+     * a reset or deepPowerDown().
+     */
+    typedef std::function<void(uint8_t id)> AlarmTimerHandler;
+
+    /**
+     * @brief Call this before AB1805::setup() to multiplex software timers on the RTC alarm
+     * 
+     * @param ramAddr Address in the RTC RAM to save the timer queue. ALARM_TIMER_RAM_SIZE (168)
+     * bytes are used starting at this address.
+     * 
+     * @param handler Function to call when a timer expires
+     * 
+     * @return An AB1805& so you can chain the withXXX() calls, fluent-style.
+     * 
+     * Up to ALARM_TIMER_MAX timers can be set using setAlarmTimer(). The hardware alarm 
+     * (REG_HUNDREDTH_ALARM - REG_WEEKDAY_ALARM) is always set to the next wake time, so it 
+     * will wake the device from sleep or deepPowerDown() at the right time. The queue is saved
+     * in the RTC RAM, so timers survive reset and deepPowerDown().
+     * 
+     * Each timer can be run any time from its deadline to its deadline plus its slack. The wake
+     * time is the earliest deadline plus slack of all of the timers, and all of the timers whose
+     * deadline has passed are run on that wake. This is the fewest wakes possible that meet every
+     * timer's window. The number of wakes saved and the duty cycle are available from 
+     * getAlarmTimerStats() and getAlarmTimerDutyCycle().
+     * 
+     * AB1805::loop() calls the handler for each expired timer using the system clock, and also
+     * when the ALM event occurs if withEventInterrupt() is used. When this is enabled the timers
+     * own the alarm, so don't use interruptAtTime() or repeatingInterrupt() as well. The alarm
+     * repeat setting is preserved by deepPowerDown() and interruptCountdownTimer().
+     */
+    AB1805 &withAlarmTimers(size_t ramAddr, AlarmTimerHandler handler) { alarmTimersEnabled = true; alarmTimerRamAddr = ramAddr; alarmTimerHandler = handler; return *this; };
+
+    /**
+     * @brief Set or replace a timer
+     * 
+     * @param id Identifies the timer. Setting a timer with an id that is already in use replaces it.
+     * 
+     * @param deadline Time the timer expires, seconds since January 1, 1970 UTC
+     * 
+     * @param periodSecs 0 for a one-shot timer, or the period in seconds (up to ALARM_TIMER_MAX_PERIOD)
+     * for a periodic timer. If periods were missed, for example during deepPowerDown(), the handler is
+     * called once and the next deadline is the next one in the future.
+     * 
+     * @param slackSecs Number of seconds after deadline the timer can be delayed so it can run on the
+     * same wake as other timers. Default: 0 (wake at deadline). For periodic timers, the next 
+     * deadline is based on the deadline, not the time the timer was run, so there is no drift.
+     * 
+     * @return true on success or false if there are too many timers or an error occurs
+     * 
+     * Requires withAlarmTimers().
+     */
+    bool setAlarmTimer(uint8_t id, time_t deadline, uint32_t periodSecs = 0, uint32_t slackSecs = 0);
+
+    /**
+     * @brief Set or replace a timer that expires a number of seconds from now
+     * 
+     * @param id Identifies the timer. Setting a timer with an id that is already in use replaces it.
+     * 
+     * @param delaySecs Number of seconds from now, using the system clock
+     * 
+     * @param periodSecs 0 for a one-shot timer, or the period in seconds for a periodic timer
+     * 
+     * @param slackSecs Number of seconds after the deadline the timer can be delayed to share a wake
+     * 
+     * @return true on success or false if the time is not valid, there are too many timers, or an error occurs
+     */
+    bool setAlarmTimerIn(uint8_t id, uint32_t delaySecs, uint32_t periodSecs = 0, uint32_t slackSecs = 0);
+
+    /**
+     * @brief Remove a timer
+     * 
+     * @param id The id passed to setAlarmTimer()
+     * 
+     * @return true on success or false if an error occurs. Removing a timer that does not exist succeeds.
+     */
+    bool cancelAlarmTimer(uint8_t id);
+
+    /**
+     * @brief Get the next timer to expire
+     * 
+     * @param deadline Filled in with the time the timer expires, seconds since January 1, 1970 UTC
+     * 
+     * @param id Filled in with the id of the timer
+     * 
+     * @return true if there is a timer or false if there are no timers
+     * 
+     * Use getNextAlarmTimerWake() to decide how long to sleep, as timers with slack may not
+     * require a wake at deadline.
+     */
+    bool getNextAlarmTimer(time_t &deadline, uint8_t &id) const;
+
+    /**
+     * @brief Get the time of the next wake needed for the timers
+     * 
+     * @param wakeTime Filled in with the earliest deadline plus slack of all of the timers, in
+     * seconds since January 1, 1970 UTC. The hardware alarm is set to this time.
+     * 
+     * @return true if there is a timer or false if there are no timers
+     */
+    bool getNextAlarmTimerWake(time_t &wakeTime) const;
+
+    /**
+     * @brief Get the statistics for the timers
+     * 
+     * The number of wakes saved by combining timers is `timersFired - wakes`.
+     */
+    const AlarmTimerStats &getAlarmTimerStats() const { return alarmTimerQueue.stats; };
+
+    /**
+     * @brief Returns the fraction of time the device has been awake since the statistics were started (0.0 - 1.0)
+     * 
+     * The awake time is updated when the timer queue is saved, including before deepPowerDown().
+     */
+    float getAlarmTimerDutyCycle() const;
+
+    /**
+     * @brief Restart the timer statistics from now
+     */
+    bool resetAlarmTimerStats();
+
+    /**
+     * @brief Returns the number of timers set with setAlarmTimer()
+     */
+    size_t getNumAlarmTimers() const { return alarmTimerQueue.numTimers; };
+
+    /**
+     * @brief Call the handler for each expired timer, then set the alarm to the next deadline
+     * 
+     * @return true on success or false if an error occurs
+     * 
+     * This is called automatically from AB1805::loop(), so you don't normally need to call it.
+     * Expired timers are only counted in getAlarmTimerStats() when this follows an RTC wake: the 
+     * first pass after AB1805::setup(), an ALM event, or an ALARM wake from updateWakeReason().
+     */
+    bool serviceAlarmTimers();
+
+    /**
+     * @brief A recurring schedule, like a cron entry, for setSchedule()
+     * 
+     * Each mask has a bit set for each value that matches. The schedule matches when the
+     * second is equal and the minute, hour, and month are set in their masks, and the day
+     * matches. As in cron, if both days and weekdays are restricted (not all bits set), the day
+     * matches if either does, otherwise it must match both.
+     */
+    typedef struct {
+        uint64_t minutes;       //!< Bit 0 - 59 for each matching minute
+        uint32_t hours;         //!< Bit 0 - 23 for each matching hour
+        uint32_t days;          //!< Bit 1 - 31 for each matching day of the month (bit 0 unused)
+        uint16_t months;        //!< Bit 0 - 11 for each matching month (0 = January, same as tm_mon)
+        uint8_t weekdays;       //!< Bit 0 - 6 for each matching day of the week (0 = Sunday, same as tm_wday)
+        uint8_t second;         //!< Second, 0 - 59
+    } Schedule;
+
+    static const uint64_t SCHEDULE_ALL_MINUTES = 0x0fffffffffffffffULL;    //!< Schedule minutes, all (bits 0 - 59)
+    static const uint32_t SCHEDULE_ALL_HOURS = 0x00ffffff;                  //!< Schedule hours, all (bits 0 - 23)
+    static const uint32_t SCHEDULE_ALL_DAYS = 0xfffffffe;                   //!< Schedule days, all (bits 1 - 31)
+    static const uint16_t SCHEDULE_ALL_MONTHS = 0x0fff;                     //!< Schedule months, all (bits 0 - 11)
+    static const uint8_t SCHEDULE_ALL_WEEKDAYS = 0x7f;                      //!< Schedule weekdays, all (bits 0 - 6)
+
+    /**
+     * @brief Function called from AB1805::loop() when the schedule matches
+     * 
+     * The parameter is the scheduled time, seconds since January 1, 1970 UTC.
+     */
+    typedef std::function<void(time_t scheduled)> ScheduleHandler;
+
+    /**
+     * @brief Convert a cron-style string into a Schedule
+     * 
+     * @param spec 5 fields, "minute hour day month weekday", or 6 fields with the second first. 
+     * Each field can be `*`, a number, a range `a-b`, or a comma-separated list of them, and 
+     * `*`, ranges, and numbers can have a step `/n`. Month is 1 - 12 and weekday is 0 - 7 (0 and 7
+     * are Sunday). The second must be a single number.
+     * 
+     * @param schedule Filled in with the schedule
+     * 
+     * @return true on success or false if the spec is not valid
+     * 
+     * Examples (times are UTC):
+     * - `7/15 * * * *` every 15 minutes at :07, :22, :37, :52
+     * - `0 6 * * 1-5` weekdays at 06:00
+     * - `0 0 1 * *` the 1st of every month at midnight
+     * - `30 * * * * *` every minute at 30 seconds
+     */
+    static bool parseSchedule(const char *spec, Schedule &schedule);
+
+    /**
+     * @brief Call a function on a recurring schedule, waking from sleep using the RTC alarm
+     * 
+     * @param schedule The schedule, see parseSchedule()
+     * 
+     * @param handler Function to call from AB1805::loop() at each scheduled time
+     * 
+     * @return true on success or false if the time is not valid or an error occurs
+     * 
+     * If the schedule can be expressed by one of the alarm repeat modes (see scheduleRepeatMode()),
+     * the alarm repeats in hardware. Otherwise the alarm is set to the next scheduled time, using the
+     * repeat mode with the shortest period that is longer than the time until then, and set to the 
+     * following scheduled time when it occurs. The handler is called when the system clock reaches the 
+     * scheduled time, and the ALM event within SCHEDULE_ALARM_TOLERANCE_SECS of it is ignored, as the RTC 
+     * can be up to a second behind the system clock. If the alarm goes off at another time, for example
+     * after the system clock was changed, the handler is not called and getScheduleFilteredWakes() is 
+     * incremented.
+     * 
+     * The schedule owns the alarm, so it can't be used with withAlarmTimers(), interruptAtTime(),
+     * or repeatingInterrupt(). 
+     * 
+     * The schedule is only kept in RAM, so it's lost on reset, including deepPowerDown() and HIBERNATE
+     * sleep. Call this again after reset. As the next time is calculated from the current time, the handler
+     * is not called for the match that woke the device; check for getWakeReason() == WakeReason::ALARM
+     * in setup() if you need to handle it.
+     */
+    bool setSchedule(const Schedule &schedule, ScheduleHandler handler);
+
+    /**
+     * @brief Call a function on a recurring schedule from a cron-style string
+     * 
+     * @param spec The schedule, see parseSchedule()
+     * 
+     * @param handler Function to call from AB1805::loop() at each scheduled time
+     * 
+     * @return true on success or false if the spec or time is not valid or an error occurs
+     */
+    bool setSchedule(const char *spec, ScheduleHandler handler);
+
+    /**
+     * @brief Stop the schedule set with setSchedule() and clear the alarm
+     */
+    bool clearSchedule();
+
+    /**
+     * @brief Get the next scheduled time, or 0 if there is no schedule
+     */
+    time_t getNextScheduleTime() const { return scheduleNext; };
+
+    /**
+     * @brief Get the number of alarms that did not match the schedule
+     */
+    uint32_t getScheduleFilteredWakes() const { return scheduleFilteredWakes; };
+
+    /**
+     * @brief Returns true if the schedule matches a time
+     * 
+     * @param schedule The schedule
+     * 
+     * @param timeptr The time (UTC). Only tm_sec, tm_min, tm_hour, tm_mday, tm_mon, and tm_wday are used.
+     */
+    static bool scheduleMatches(const Schedule &schedule, const struct tm *timeptr);
+
+    /**
+     * @brief Get the first time after a time that a schedule matches
+     * 
+     * @param schedule The schedule
+     * 
+     * @param after The time, seconds since January 1, 1970 UTC. The result is later than this.
+     * 
+     * @return The time, or 0 if the schedule does not match within 5 years
+     */
+    static time_t nextScheduleTime(const Schedule &schedule, time_t after);
+
+    /**
+     * @brief Get the alarm repeat mode that exactly matches a schedule
+     * 
+     * @param schedule The schedule
+     * 
+     * @return `REG_TIMER_CTRL_RPT_SEC` through `REG_TIMER_CTRL_RPT_MON`, or `REG_TIMER_CTRL_RPT_DIS`
+     * if no repeat mode matches it exactly and the alarm needs to be set for each time.
+     */
+    static uint8_t scheduleRepeatMode(const Schedule &schedule);
+
+    /**
+     * @brief Set the alarm again if needed and call the handler if the scheduled time has passed
+     * 
+     * This is called automatically from AB1805::loop(), so you don't normally need to call it.
+     */
+    bool serviceSchedule();
+
+    static const time_t SCHEDULE_ALARM_TOLERANCE_SECS = 2;     //!< An ALM this close to a scheduled time is for that time, not a filtered wake
+
+    /**
+     * @brief Interrupt at a time in the future, either in minutes or seconds
+     * 
+     * @param value Value in seconds or minutes. Must be 0 < value <= 255! 
+     * 
+     * @param minutes True if minutes, false if seconds
+     * 
+     * @return true on success or false if an error occurs.
+
+     * The countdown timer works even if the RTC has not been set yet, but is more
+     * limited in range (maximum: 255 minutes).
+     */
+    bool interruptCountdownTimer(int value, bool minutes);
+
+    /**
+     * @brief Interrupt after a number of milliseconds, using the countdown timer
+     * 
+     * @param ms Number of milliseconds. Can be from 1 ms to about 49 days.
+     * 
+     * @return true on success or false if an error occurs.
+     * 
+     * The countdown timer clock (4.096 kHz, or 128 Hz on the RC oscillator, 64 Hz, 1 Hz, or 1/60 Hz)
+     * is the finest one that can count the duration in 255 ticks. If the clock that fits is too
+     * coarse to be exact, or the duration is longer than 255 minutes, the duration is split into 
+     * segments (see countdownTimerSegment()). The next segment is set when the TIM interrupt for 
+     * the previous one is handled by processEvents(), and the remaining time is measured from 
+     * millis() so that the first tick of each segment being short does not add up. The TIM event 
+     * handler is only called after the last segment.
+     * 
+     * Durations that need more than one segment require withEventInterrupt(). Unlike 
+     * interruptCountdownTimer(), this does not change the watchdog. Calling setCountdownTimer(),
+     * interruptCountdownTimer(), or deepPowerDown() cancels it.
+     */
+    bool setCountdownTimerMillis(uint32_t ms);
+
+    /**
+     * @brief Returns true if setCountdownTimerMillis() has more segments to run
+     */
+    bool isCountdownTimerChained() const { return countdownTimerMs != 0; };
+
+    /**
+     * @brief Calculates the countdown timer settings for the first segment of a duration
+     * 
+     * @param ms Duration in milliseconds
+     * 
+     * @param rcOscillator true if the RC oscillator is used (REG_OSC_CTRL_OSEL), in which case the 
+     * fastest clock is 128 Hz instead of 4.096 kHz
+     * 
+     * @param ticks Filled in with the REG_TIMER value (1 - 255)
+     * 
+     * @param tfs Filled in with the TFS clock value (`REG_TIMER_CTRL_TFS_FAST`, etc.)
+     * 
+     * @return The number of milliseconds of ms that this segment covers. If it's less than ms, 
+     * another segment is needed for the rest.
+     * 
+     * The finest clock that fits the duration in 255 ticks is used. The segment is rounded down 
+     * to a whole number of ticks and the remainder is left for a finer clock, unless the 
+     * remainder would be less than COUNTDOWN_TIMER_MIN_SEGMENT_MS, in which case it's rounded 
+     * to the nearest tick and the duration is done in one segment.
+     */
+    static uint32_t countdownTimerSegment(uint32_t ms, bool rcOscillator, uint8_t &ticks, uint8_t &tfs);
+
+    static const uint32_t COUNTDOWN_TIMER_MIN_SEGMENT_MS = 20;  //!< Shortest remainder worth another countdown timer segment, in milliseconds
+
+    /**
+     * @brief Function called from AB1805::loop() for startPeriodicTick()
+     * 
+     * The parameter is the number of ticks since the last call. It's normally 1, and more than 1 if
+     * ticks were missed because AB1805::loop() was not called often enough. Missed ticks are also
+     * counted in getPeriodicTickMissed().
+     */
+    typedef std::function<void(uint32_t ticks)> PeriodicTickHandler;
+
+    /**
+     * @brief Start a periodic interrupt using the countdown timer repeat mode (TRPT)
+     * 
+     * @param periodUs Period in microseconds, from 244 (4.096 kHz) to 4294967295 (about 71 minutes).
+     * For example, 15625 for 64 Hz or 60000000 for once a minute. Periods over 71 minutes run at
+     * 71 minutes. 
+     * 
+     * @param handler Function to call from AB1805::loop() on each tick
+     * 
+     * @param pulse true to use pulse interrupts (REG_TIMER_CTRL_TM), false to use level interrupts.
+     * In pulse mode, each tick is counted in the FOUT/nIRQ interrupt service routine, so ticks are 
+     * not missed if AB1805::loop() is late. In level mode, nIRQ stays asserted until processEvents()
+     * clears TIM, and missed ticks are detected from the elapsed time.
+     * 
+     * @return true on success or false if an error occurs.
+     * 
+     * The timer reloads from REG_TIMER_INITIAL in hardware, so the ticks do not drift from
+     * software latency. The clock (4.096 kHz or 128 Hz, 64 Hz, 1 Hz, or 1/60 Hz) is the finest
+     * one that fits the period in 255 ticks; see getPeriodicTickPeriodUs() for the actual period.
+     * 
+     * Requires withEventInterrupt(). The TIM event handler is not called for ticks. Calling 
+     * setCountdownTimer(), setCountdownTimerMillis(), interruptCountdownTimer(), or deepPowerDown() 
+     * stops the tick. In pulse mode, other interrupts on nIRQ at the same time can be counted as ticks.
+     */
+    bool startPeriodicTick(uint32_t periodUs, PeriodicTickHandler handler, bool pulse = false);
+
+    /**
+     * @brief Stop the interrupt started by startPeriodicTick()
+     * 
+     * @return true on success or false if an error occurs.
+     */
+    bool stopPeriodicTick();
+
+    /**
+     * @brief Get the actual period of startPeriodicTick() in microseconds, after rounding to the clock
+     */
+    uint32_t getPeriodicTickPeriodUs() const { return periodicTickPeriodUs; };
+
+    /**
+     * @brief Get the number of ticks since startPeriodicTick(), including missed ticks
+     */
+    uint32_t getPeriodicTickCount() const { return periodicTickCount; };
+
+    /**
+     * @brief Get the number of ticks that were missed since startPeriodicTick()
+     */
+    uint32_t getPeriodicTickMissed() const { return periodicTickMissed; };
+
+    /**
+     * @brief Calculates the countdown timer settings for a periodic tick
+     * 
+     * @param periodUs Period in microseconds
+     * 
+     * @param rcOscillator true if the RC oscillator is used (REG_OSC_CTRL_OSEL), in which case the 
+     * fastest clock is 128 Hz instead of 4.096 kHz
+     * 
+     * @param ticks Filled in with the number of clock ticks per period (1 - 255)
+     * 
+     * @param tfs Filled in with the TFS clock value (`REG_TIMER_CTRL_TFS_FAST`, etc.)
+     * 
+     * @return The actual period in microseconds
+     */
+    static uint32_t periodicTickSettings(uint32_t periodUs, bool rcOscillator, uint8_t &ticks, uint8_t &tfs);
+
+    /**
+     * @brief Enters deep power down reset mode, using the EN pin
+     * 
+     * @param seconds number of seconds to power down. Must be 0 < seconds <= 255.
+     * The default is 30 seconds. If time-sensitive, 10 seconds is probably sufficient.
+     * 
+     * @return true on success or false if an error occurs.
+     * 
+     * This method powers down the MCU and cellular modem by using a combination
+     * of the EN and RST pins. This super-reset is similar to what would happen if
+     * you disconnected the battery.
+     * 
+     * It assumes that EN is connected to /nIRQ2 (PSW) on the AB1805 using an 
+     * N-channel MOSFET and RST is connected to /RESET on the AB1805.
+     * 
+     * After the deep reset finishes, the device will reboot and go back through
+     * setup() again. Calling getWakeReset() will return the reason `DEEP_POWER_DOWN`.
+     * 
+     * This works even if the RTC has not been set yet. For longer durations, use 
+     * deepPowerDownFor() or deepPowerDownUntil().
+     */
+    bool deepPowerDown(int seconds = 30);
+
+    /**
+     * @brief How the device is woken from deepPowerDown()
+     */
+    enum class DeepPowerDownWake : uint8_t {
+        COUNTDOWN_SECONDS = 1,  //!< Countdown timer at 1 Hz (up to 255 seconds)
+        COUNTDOWN_MINUTES,      //!< Countdown timer at 1/60 Hz (up to 255 minutes, RTC not set)
+        ALARM                   //!< Alarm registers (RTC set, up to 1 year)
+    };
+
+    /**
+     * @brief Record of the last deepPowerDown(), saved in the RTC RAM (see withDeepPowerDownRecord())
+     */
+    typedef struct {
+        uint32_t magic;         //!< DEEP_POWER_DOWN_MAGIC
+        uint32_t sleepTime;     //!< RTC time when powering down, seconds since January 1, 1970 UTC
+        uint32_t plannedWake;   //!< RTC time the device should wake, seconds since January 1, 1970 UTC
+        uint8_t wake;           //!< How the wake was set (DeepPowerDownWake)
+        uint8_t reserved[3];    //!< Reserved, currently 0
+    } DeepPowerDownRecord;
+
+    static const uint32_t DEEP_POWER_DOWN_MAGIC = 0x41424334;   //!< Magic bytes to detect a valid DeepPowerDownRecord in RTC RAM
+    static const size_t DEEP_POWER_DOWN_RAM_SIZE = sizeof(DeepPowerDownRecord); //!< Bytes of RTC RAM used by withDeepPowerDownRecord()
+
+    /**
+     * @brief Call this before AB1805::setup() to save the planned wake time of deepPowerDown() in RTC RAM
+     * 
+     * @param ramAddr Address in the RTC RAM to save the record. DEEP_POWER_DOWN_RAM_SIZE (16) bytes
+     * are used starting at this address.
+     * 
+     * @return An AB1805& so you can chain the withXXX() calls, fluent-style.
+     * 
+     * On the next AB1805::setup(), the record is read and cleared, and the RTC time is saved as the 
+     * actual wake time. Use getLastDeepPowerDown() to get the difference between the planned and 
+     * actual wake. The record is only saved if the RTC has been set.
+     */
+    AB1805 &withDeepPowerDownRecord(size_t ramAddr) { deepPowerDownRecordEnabled = true; deepPowerDownRamAddr = ramAddr; return *this; };
+
+    /**
+     * @brief Enters deep power down reset mode for a duration that can be longer than 255 seconds
+     * 
+     * @param duration Duration as a std::chrono::seconds, for example `std::chrono::hours(6)`
+     * 
+     * @return true on success or false if an error occurs. On success this does not return.
+     * 
+     * The wake is set using:
+     * 
+     * - The countdown timer in seconds for up to 255 seconds
+     * - The alarm registers when the RTC has been set, up to 1 year. If withAlarmTimers() is used
+     * and the next timer wake is earlier, the device wakes for the timer instead. The alarm is 
+     * cleared in setup() after waking, then set again for the next timer if withAlarmTimers() is used.
+     * - The countdown timer in minutes if the RTC has not been set. This is rounded up to whole 
+     * minutes and limited to 255 minutes.
+     * 
+     * The MCU is not powered during the whole duration. See deepPowerDown() for the hardware
+     * requirements.
+     */
+    bool deepPowerDownFor(std::chrono::seconds duration);
+
+    /**
+     * @brief Enters deep power down reset mode until a time
+     * 
+     * @param wakeTime The time to wake, seconds since January 1, 1970 UTC
+     * 
+     * @return true on success or false if the time is not valid or an error occurs. 
+     * On success this does not return.
+     * 
+     * See deepPowerDownFor().
+     */
+    bool deepPowerDownUntil(time_t wakeTime);
+
+    /**
+     * @brief Get the record of the deepPowerDown() before this boot
+     * 
+     * @param record Filled in with the record, including the planned wake time
+     * 
+     * @param actualWake Filled in with the RTC time in AB1805::setup(), seconds since January 1, 1970 UTC. 
+     * `actualWake - record.plannedWake` is the wake error in seconds, including the time to boot.
+     * 
+     * @return true if there is a record, or false if the last reset was not from deepPowerDown() 
+     * or withDeepPowerDownRecord() was not used.
+     */
+    bool getLastDeepPowerDown(DeepPowerDownRecord &record, time_t &actualWake) const;
+
+    /**
+     * @brief Used internally by interruptCountdownTimer and deepPowerDown.
+     * 
+     * @param value Value in seconds or minutes. Must be 0 < value <= 255! 
+     * 
+     * @param minutes True if minutes, false if seconds
+     * 
+     * @return true on success or false if an error occurs.
+     * 
+     * The countdown timer works even if the RTC has not been set yet, but is more
+     * limited in range (maximum: 255 minutes).
+     */
+    bool setCountdownTimer(int value, bool minutes);
+
+    /**
+     * @brief Adds the register changes for setCountdownTimer() to a batch
+     * 
+     * @param batch The batch to add to. This includes barrier() calls.
+     * 
+     * @param value Value in seconds or minutes. Must be 0 < value <= 255! 
+     * 
+     * @param minutes True if minutes, false if seconds
+     * 
+     * This is used when setting the countdown timer is part of a larger sequence of
+     * register changes, such as deepPowerDown().
+     */
+    void addCountdownTimer(RegisterBatch &batch, int value, bool minutes);
+
+    /**
+     * @brief Adds the register changes to start the countdown timer to a batch
+     * 
+     * @param batch The batch to add to. This includes barrier() calls.
+     * 
+     * @param ticks Value for REG_TIMER (1 - 255)
+     * 
+     * @param tfs The clock frequency, `REG_TIMER_CTRL_TFS_FAST`, `REG_TIMER_CTRL_TFS_64`, 
+     * `REG_TIMER_CTRL_TFS_1`, or `REG_TIMER_CTRL_TFS_1_60`.
+     * 
+     * @param flags 0 for a one-shot timer with level interrupt, or `REG_TIMER_CTRL_TRPT` to repeat with
+     * ticks in REG_TIMER_INITIAL, logically ORed with `REG_TIMER_CTRL_TM` for pulse interrupts.
+     * 
+     * Unlike addCountdownTimer(), this does not cancel setCountdownTimerMillis() or startPeriodicTick().
+     */
+    void addCountdownTimerTicks(RegisterBatch &batch, uint8_t ticks, uint8_t tfs, uint8_t flags = 0);
+
+    /**
+     * @brief Adds the register changes for repeatingInterrupt() to a batch
+     * 
+     * @param batch The batch to add to
+     * 
+     * @param timeptr The time to interrupt at, see repeatingInterrupt()
+     * 
+     * @param rptValue The repeat mode, see repeatingInterrupt()
+     * 
+     * @param hundredths Value for REG_HUNDREDTH_ALARM, see repeatingInterrupt()
+     * 
+     * Unlike repeatingInterrupt(), this does not disable the watchdog. If timeptr is NULL, only
+     * the hundredths alarm register is set.
+     */
+    void addRepeatingInterrupt(RegisterBatch &batch, const struct tm *timeptr, uint8_t rptValue, uint8_t hundredths = 0x00);
+
+    /**
+     * @brief Enable trickle charging mode
+     * 
+     * @param diodeAndRout Pass 0 to disable the trickle charger or one diode constant and one rout constant below.
+     * 
+     * @return true on success or false if an error occurs.
+     * 
+     * Diode settings determine the voltage applied to the supercap or battery in trickle charge mode.
+     * This is from VCC, which is generally 3V3, so this will be a voltage of 2.7V or 3.0V. This makes
+     * the trickle charger compatible with a wider variety of supercaps.
+     * 
+     * - `REG_TRICKLE_DIODE_0_6` diode 0.6V drop
+     * - `REG_TRICKLE_DIODE_0_3` diode 0.3V drop
+     * 
+     * The ROUT setting determines the series resistor to the supercap. This determines charging speed.
+     * 
+     * - `REG_TRICKLE_ROUT_11K` rout 11K
+     * - `REG_TRICKLE_ROUT_6K` rout 6K
+     * - `REG_TRICKLE_ROUT_3K` rout 3K
+     * 
+     * The sample design includes an additional 1.5K series resistance using an external resistor, so
+     * applying 3K results in an actual series resistance of 4.5K.
+     * 
+     */
+    bool setTrickle(uint8_t diodeAndRout);
+
+    /**
+     * @brief Returns true if VBAT input is above minimum operating voltage (1.2V)
+     * 
+     * This function will check if trickle charging is enabled first. If enabled, it will be turned off,
+     * the value checked, then turned back on again.
+     */
+    bool isVBATAboveMin() { bool bResult = false; checkVBAT(REG_ASTAT_BMIN, bResult); return bResult; };
+
+    /**
+     * @brief Returns true if VBAT input is above BREF voltage
+     * 
+     * The power-up default for BREF is 1.4V (`REG_BREF_CTRL_14_16`), so this provides
+     * some additional margin over the minimum voltage (1.2V). BREF can be changed
+     * to check for higher voltages (fully charged, for example) but it takes several
+     * seconds for the values to settle after making a change, so you don't want to
+     * change it too often.
+     * 
+     * This function will check if trickle charging is enabled first. If enabled, it will be turned off,
+     * the value checked, then turned back on again.
+     */
+    bool isVBATAboveBREF() { bool bResult = false; checkVBAT(REG_ASTAT_BBOD, bResult); return bResult; };
+
+    /**
+     * @brief Checks VBAT status
+     * 
+     * @param mask Either REG_ASTAT_BBOD (compare againt BREF) or REG_ASTAT_BMIN (compare against minimum, 1.2V)
+     * 
+     * @param isAbove True if VBAT is above the specified voltage, or false if not
+     * 
+     * This function will check if trickle charging is enabled first. If enabled, it will be turned off,
+     * the value checked, then turned back on again.
+     */
+    bool checkVBAT(uint8_t mask, bool &isAbove);
+
+    /**
+     * @brief Set the RTC from the system clock
+     * 
+     * This is called automatically from AB1805::loop() when the time is updated from the cloud.
+     * You normally don't need to call this yourself.
+     */
+    bool setRtcFromSystem();
+
+    /**
+     * @brief Set the RTC from the system clock, aligned to the second boundary
+     * 
+     * @param maxWaitMs Maximum time to wait for the system clock second to change. Default: 1100.
+     * 
+     * @return true on success or false if an error occurs or the system clock is not valid.
+     * 
+     * The system clock (`Time.now()`) only has 1 second resolution, so setRtcFromSystem() can
+     * be up to 1 second off. This function blocks until the system clock changes to the next
+     * second, so the fractional second is known, then writes the time including REG_HUNDREDTH.
+     * The duration of the I2C write is measured before waiting, using a write of the same length, 
+     * and compensated for, so the RTC is typically within 10 milliseconds of the system clock.
+     * 
+     * WRTC is set before waiting so only the time registers write is done after the second
+     * boundary. If the second does not change within maxWaitMs, the time is set without 
+     * alignment, like setRtcFromSystem().
+     * 
+     * This is used from AB1805::loop() after the time is set from the cloud if
+     * withAlignedRtcSet() is used.
+     */
+    bool setRtcFromSystemAligned(unsigned long maxWaitMs = 1100);
+
+    /**
+     * @brief Call this before AB1805::setup() to set the RTC from the cloud time aligned to the second
+     * 
+     * @param enable true to use setRtcFromSystemAligned() from loop() (default), false to 
+     * use setRtcFromTime().
+     * 
+     * @return An AB1805& so you can chain the withXXX() calls, fluent-style.
+     * 
+     * This makes AB1805::loop() block for up to 1 second, once, when the time is first
+     * received from the cloud.
+     */
+    AB1805 &withAlignedRtcSet(bool enable = true) { alignedRtcSet = enable; return *this; };
+
+    /**
+     * @brief Sets the RTC from a time_t
+     * 
+     * @param time The time (in seconds since January 1, 1970, UNIX epoch), UTC.
+     * 
+     * @param lock Lock the I2C bus. Default = true. Pass false if surrounding a block of
+     * related calls with a wire.lock() and wire.unlock() so the block cannot be interrupted
+     * with other I2C operations.
+     * 
+     * This is called automatically from AB1805::loop() when the time is updated from the cloud.
+     * You normally don't need to call this yourself. You might call this if you are also getting
+     * time from an external source like a GPS.
+     */
+    bool setRtcFromTime(time_t time, bool lock = true);
+
+    /**
+     * @brief Sets the RTC from a time_t
+     * 
+     * @param timeptr A struct tm specifying the time. 
+     * 
+     * @param lock Lock the I2C bus. Default = true. Pass false if surrounding a block of
+     * related calls with a wire.lock() and wire.unlock() so the block cannot be interrupted
+     * with other I2C operations.
+     * 
+     * The following fields are required:
+     * - tm_sec	  seconds after the minute	0-61 (usually 0-59)
+     * - tm_min	  minutes after the hour 0-59
+     * - tm_hour  hours since midnight 0-23
+     * - tm_mday  day of the month 1-31
+     * - tm_mon	  months since January 0-11 (not 1-12!)
+     * - tm_year  years since 1900 (note: 2020 = 120)
+     * - tm_wday  days since Sunday	0-6
+     * 
+     * Note that you must include tm_wday and 0 = Sunday, 1 = Monday, ...
+     * Month of year is 0 - 11, NOT 1 - 12!
+     * Year is years since 1900, so 2020 has 120 in the tm_year field!
+     * 
+     * This is called automatically from AB1805::loop() when the time is updated from the cloud.
+     * You normally don't need to call this yourself. You might call this if you are also getting
+     * time from an external source like a GPS.
+     */
+    bool setRtcFromTm(const struct tm *timeptr, bool lock = true);
+
+    /**
+     * @brief Sets the RTC from milliseconds, including the fractional second
+     * 
+     * @param ms The time in milliseconds since January 1, 1970, UTC.
+     * 
+     * @param lock Lock the I2C bus. Default = true. Pass false if surrounding a block of
+     * related calls with a wire.lock() and wire.unlock() so the block cannot be interrupted
+     * with other I2C operations.
+     * 
+     * The fractional second is written to REG_HUNDREDTH, so it's truncated to 10 millisecond 
+     * resolution. setRtcFromTime() and setRtcFromTm() always set the hundredths to 0.
+     */
+    bool setRtcFromMillis(uint64_t ms, bool lock = true);
+
+    /**
+     * @brief Sets the RTC from register values
+     * 
+     * @param array Array of 8 bytes: hundredths, seconds, minutes, hours, date, month, year,
+     * weekday, all BCD.
+     * 
+     * @param lock Lock the I2C bus. Default = true. Pass false if surrounding a block of
+     * related calls with a wire.lock() and wire.unlock() so the block cannot be interrupted
+     * with other I2C operations.
+     * 
+     * Sets WRTC, writes the time registers, then clears WRTC to indicate that the RTC
+     * has been set. This is used by setRtcFromTime() and setRtcFromTm().
+     */
+    bool setRtcFromRegisters(const uint8_t *array, bool lock = true);
+
+    
+    /**
+     * @brief Reads a AB1805 register (single byte)
+     * 
+     * @param regAddr Register address to read from (0x00 - 0xff)
+     * 
+     * @param value Filled in with the value from the register
+     * 
+     * @param lock Lock the I2C bus. Default = true. Pass false if surrounding a block of
+     * related calls with a wire.lock() and wire.unlock() so the block cannot be interrupted
+     * with other I2C operations.
+     * 
+     * @return true on success or false on error
+     * 
+     * There is also an overload that returns value instead of passing it by reference.
+     */
+    bool readRegister(uint8_t regAddr, uint8_t &value, bool lock = true);
+
+    /**
+     * @brief Reads a AB1805 register (single byte) and returns it
+     * 
+     * @param regAddr Register address to read from (0x00 - 0xff)
+     * 
+     * @param lock Lock the I2C bus. Default = true. Pass false if surrounding a block of
+     * related calls with a wire.lock() and wire.unlock() so the block cannot be interrupted
+     * with other I2C operations.
+     * 
+     * @return The value of the register or 0x00 if it could not be read.
+     * 
+     * There is an overload that takes a uint8_t &value parameter which is generally
+     * better because you can tell the difference between a value of 0 and a failure
+     * (false is returned).
+     */
+    uint8_t readRegister(uint8_t regAddr, bool lock = true);
+
+    /**
+     * @brief Reads sequential registers
+     * 
+     * @param regAddr Register address to start reading from (0x00 - 0xff) 
+     * 
+     * @param array Array of uint8_t values, filled in by this call
+     * 
+     * @param num Number of registers to read
+     * 
+     * @param lock Lock the I2C bus. Default = true. Pass false if surrounding a block of
+     * related calls with a wire.lock() and wire.unlock() so the block cannot be interrupted
+     * with other I2C operations.
+     * 
+     * Reads a number of registers at once. This is done when reading the RTC value so
+     * it's atomic (counters will not be incremented in the middle of a read). Also used
+     * for reading the device RAM.
+     * 
+     * Do not read past address 0xff. 
+     */
+    bool readRegisters(uint8_t regAddr, uint8_t *array, size_t num, bool lock = true);
+
+
+    /**
+     * @brief Writes a AB1805 register (single byte)
+     * 
+     * @param regAddr Register address to write to (0x00 - 0xff)
+     * 
+     * @param value This value is written to the register
+     * 
+     * @param lock Lock the I2C bus. Default = true. Pass false if surrounding a block of
+     * related calls with a wire.lock() and wire.unlock() so the block cannot be interrupted
+     * with other I2C operations.
+     * 
+     * @return true on success or false on error
+     */
+    bool writeRegister(uint8_t regAddr, uint8_t value, bool lock = true);
+
+    /**
+     * @brief Writes sequential AB1805 registers
+     * 
+     * @param regAddr Register address to start writing to (0x00 - 0xff)
+     * 
+     * @param array Array of uint8_t values to write
+     * 
+     * @param num Number of registers to write
+     * 
+     * @param lock Lock the I2C bus. Default = true. Pass false if surrounding a block of
+     * related calls with a wire.lock() and wire.unlock() so the block cannot be interrupted
+     * with other I2C operations.
+     * 
+     * @return true on success or false on error
+     * 
+     * Do not write past address 0xff. 
+     */
+    bool writeRegisters(uint8_t regAddr, const uint8_t *array, size_t num, bool lock = true);
+
+    /**
+     * @brief Writes sequential key-protected AB1805 registers
+     * 
+     * @param key The value to write to REG_CONFIG_KEY first. `REG_CONFIG_KEY_OSC_CTRL` for
+     * REG_OSC_CTRL or `REG_CONFIG_KEY_OTHER` for REG_TRICKLE, REG_BREF_CTRL, REG_AFCTRL,
+     * REG_BATMODE_IO, and REG_OCTRL.
+     * 
+     * @param regAddr Register address to start writing to (0x00 - 0xff)
+     * 
+     * @param array Array of uint8_t values to write
+     * 
+     * @param num Number of registers to write
+     * 
+     * @param lock Lock the I2C bus. Default = true. Pass false if surrounding a block of
+     * related calls with a wire.lock() and wire.unlock() so the block cannot be interrupted
+     * with other I2C operations.
+     * 
+     * @return true on success or false on error
+     * 
+     * The key only applies to the write transaction that immediately follows it, so each 
+     * register is written in its own transaction after its own key write, two I2C transactions
+     * per register. The registers must all use the same key.
+     */
+    bool writeRegistersWithKey(uint8_t key, uint8_t regAddr, const uint8_t *array, size_t num, bool lock = true);
+
+    /**
+     * @brief Writes a AB1805 register (single byte) with masking of existing value
+     * 
+     * @param regAddr Register address to read from and write to (0x00 - 0xff)
+     * 
+     * @param andValue The existing register values is logically ANDed with this value
+     * 
+     * @param orValue This value is logically ORed with this value before storing
+     * 
+     * @param lock Lock the I2C bus. Default = true. Pass false if surrounding a block of
+     * related calls with a wire.lock() and wire.unlock() so the block cannot be interrupted
+     * with other I2C operations.
+     * 
+     * @return true on success or false on error
+     * 
+     * If lock is true then the lock surrounds both the read and write, so the operation is
+     * atomic.
+     * 
+     * If the value is unchanged after the andValue and orValue is applied, the write is skipped.
+     * The read is always done, unless the register is held in the shadow register cache
+     * (see withRegisterCache()).
+     */
+    bool maskRegister(uint8_t regAddr, uint8_t andValue, uint8_t orValue, bool lock = true);
+
+    /**
+     * @brief Returns true if a bit in a register is 0
+     * 
+     * @param regAddr Register address to read from (0x00 - 0xff)
+     * 
+     * @param bitMask Mask to check. Note that the bitMask should have a 1 bit where you are checking
+     * for a 0 bit! Normally there is only one bit set in bitMask.
+     * 
+     * @param lock Lock the I2C bus. Default = true. Pass false if surrounding a block of
+     * related calls with a wire.lock() and wire.unlock() so the block cannot be interrupted
+     * with other I2C operations.
+     * 
+     * @return true if the register could be read and the bit is 0, otherwise false.
+     */
+    bool isBitClear(uint8_t regAddr, uint8_t bitMask, bool lock = true);
+
+    /**
+     * @brief Returns true if a bit in a register is 1
+     * 
+     * @param regAddr Register address to read from (0x00 - 0xff)
+     * 
+     * @param bitMask Mask to check. The bitMask should have a 1 bit where you are checking
+     * for a 1 bit. Normally there is only one bit set in bitMask.
+     * 
+     * @param lock Lock the I2C bus. Default = true. Pass false if surrounding a block of
+     * related calls with a wire.lock() and wire.unlock() so the block cannot be interrupted
+     * with other I2C operations.
+     * 
+     * @return true if the register could be read and the bit is 1, otherwise false.
+     */
+    bool isBitSet(uint8_t regAddr, uint8_t bitMask, bool lock = true);
+
+    /**
+     * @brief Clear a bit in a register
+     * 
+     * @param regAddr The address of the register to read/write
+     * 
+     * @param bitMask The bit mask to clear. This has a 1 bit in the bit you want to clear, and will typically
+     * only have one bit set, though you can clear multiple bits at the same time with this function.
+     * 
+     * @param lock Whether to lock the I2C bus, the default is true. You pass false if you are grouping
+     * together functions in a single lock, for example doing a read/modify/write cycle.
+     * 
+     * The bit is cleared only if set. If the bit(s) are already cleared, then only the read is done,
+     * and the write is skipped. A read is always done, unless the register is held in the shadow
+     * register cache (see withRegisterCache()).
+     * 
+     * If lock is true, then the lock surround both the read and write so the entire operation is atomic.
+     */
+    bool clearRegisterBit(uint8_t regAddr, uint8_t bitMask, bool lock = true);
+
+    /**
+     * @brief Sets a bit in a register
+     * 
+     * @param regAddr The address of the register to read/write
+     * 
+     * @param bitMask The bit mask to set. This has a 1 bit in the bit you want to set, and will typically
+     * only have one bit set, though you can set multiple bits at the same time with this function.
+     * 
+     * @param lock Whether to lock the I2C bus, the default is true. You pass false if you are grouping
+     * together functions in a single lock, for example doing a read/modify/write cycle.
+     * 
+     * The bit is set only if cleared (0). If the bit(s) are already set, then only the read is done,
+     * and the write is skipped. A read is always done, unless the register is held in the shadow
+     * register cache (see withRegisterCache()).
+     * 
+     * If lock is true, then the lock surround both the read and write so the entire operation is atomic.
+     */
+    bool setRegisterBit(uint8_t regAddr, uint8_t bitMask, bool lock = true);
+
+    /**
+     * @brief Returns the REG_CONFIG_KEY value required to write a register
+     * 
+     * @param regAddr Register address (0x00 - 0xff)
+     * 
+     * @return `REG_CONFIG_KEY_OSC_CTRL` for REG_OSC_CTRL, `REG_CONFIG_KEY_OTHER` for REG_TRICKLE,
+     * REG_BREF_CTRL, REG_AFCTRL, REG_BATMODE_IO, and REG_OCTRL, or 0 if no key is required.
+     */
+    static uint8_t configKeyForRegister(uint8_t regAddr);
+
+    /**
+     * @brief Collects a sequence of register changes and writes them with as few I2C transactions as possible
+     * 
+     * Create one on the stack, add changes with set(), clear(), mask(), write(), and writeBlock(),
+     * then call commit(). Nothing is sent to the chip until commit().
+     * 
+     * When committing:
+     * - Multiple changes to the same register are combined into a single final value
+     * - Registers whose final value matches the current value are not written
+     * - The current values of registers that are masked are read in a single burst read (or
+     * from the shadow register cache, see withRegisterCache())
+     * - Adjacent registers are written in a single burst write
+     * - Key-protected registers are written one at a time, each preceded by the appropriate 
+     * REG_CONFIG_KEY write
+     * - The whole operation is done with the I2C bus locked
+     * 
+     * Registers are written in increasing address order. When the order matters, such as 
+     * stopping the countdown timer before changing it, or entering sleep mode last, call
+     * barrier(). All of the changes before the barrier are written before any changes after it.
+     * 
+     * Only registers 0x00 - 0x3f can be used. Use writeRam() for the RTC RAM.
+     */
+    class RegisterBatch {
+    public:
+        /**
+         * @brief Construct a batch for an AB1805 object. 
+         */
+        RegisterBatch(AB1805 &parent) : parent(parent) {};
+
+        /**
+         * @brief Set the register to value
+         */
+        RegisterBatch &write(uint8_t regAddr, uint8_t value) { return mask(regAddr, 0x00, value); };
+
+        /**
+         * @brief Set sequential registers from an array of values
+         */
+        RegisterBatch &writeBlock(uint8_t regAddr, const uint8_t *array, size_t num);
+
+        /**
+         * @brief Set the bits in bitMask
+         */
+        RegisterBatch &set(uint8_t regAddr, uint8_t bitMask) { return mask(regAddr, 0xff, bitMask); };
+
+        /**
+         * @brief Clear the bits in bitMask
+         */
+        RegisterBatch &clear(uint8_t regAddr, uint8_t bitMask) { return mask(regAddr, (uint8_t)~bitMask, 0x00); };
+
+        /**
+         * @brief The register value is logically ANDed with andValue then ORed with orValue
+         */
+        RegisterBatch &mask(uint8_t regAddr, uint8_t andValue, uint8_t orValue);
+
+        /**
+         * @brief Changes added after this call are written after all of the changes before it
+         */
+        RegisterBatch &barrier();
+
+        /**
+         * @brief Write the changes to the chip
+         * 
+         * @param lock Lock the I2C bus. Default = true. Pass false if surrounding a block of
+         * related calls with a wire.lock() and wire.unlock() so the block cannot be interrupted
+         * with other I2C operations.
+         * 
+         * @return true on success or false on error. After commit the batch is empty and can be reused.
+         */
+        bool commit(bool lock = true);
+
+        /**
+         * @brief Discard all changes without writing them
+         */
+        void reset();
+
+        static const size_t MAX_ENTRIES = 32; //!< Maximum number of distinct register changes per batch
+        static const uint8_t MAX_REG_ADDR = 0x3f; //!< Highest register address that can be used in a batch
+
+    protected:
+        /**
+         * @brief One register change. Multiple changes to the same register in a stage are combined.
+         */
+        typedef struct {
+            uint8_t regAddr;    //!< Register address
+            uint8_t andValue;   //!< Existing value is ANDed with this value (0x00 = value is fully replaced)
+            uint8_t orValue;    //!< Then ORed with this value
+            uint8_t stage;      //!< Incremented by barrier()
+        } Entry;
+
+        AB1805 &parent;                 //!< Object to write to
+        Entry entries[MAX_ENTRIES];     //!< Changes, in the order they were added
+        size_t numEntries = 0;          //!< Number of used entries
+        uint8_t stage = 0;              //!< Current stage, incremented by barrier()
+        bool overflow = false;          //!< Too many changes or an invalid address was used
+    };
+
+	/**
+	 * @brief Returns the length of the RTC RAM in bytes (always 256)
+	 */
+	inline size_t length() { return 256; }
+
+	/**
+	 * @brief Erases the RTC RAM to 0x00 values
+     * 
+     * @param lock Whether to lock the I2C bus, the default is true. You pass false if you are grouping
+     * together functions in a single lock, for example doing a read/modify/write cycle.
+	 */
+	bool eraseRam(bool lock = true);
+
+	/**
+	 * @brief Read from RTC RAM using EEPROM-style API
+	 *
+	 * @param ramAddr The address in the RTC RAM to read from
+     * 
+	 * @param t The variable to read to. This must be a simple type (bool, int, float, etc.)
+     * or struct. It cannot save a c-string (const char *), String, or other class. You
+     * typically cannot get any pointers or structs containing pointers.
+	 */
+    template <typename T> T &get(size_t ramAddr, T &t) {
+        readRam(ramAddr, (uint8_t *)&t, sizeof(T));
+        return t;
+    }
+
+	/**
+	 * @brief Write from RTC RAM using EEPROM-style API
+	 *
+	 * @param ramAddr The address in the RTC RAM to write to
+     * 
+	 * @param t The variable to write from. t is not modified. This must be a simple type (bool, int, float, etc.)
+     * or struct. It cannot save a c-string (const char *), String, or other class. You
+     * typically cannot save any pointers or structs containing pointers.
+	 */
+    template <typename T> const T &put(size_t ramAddr, const T &t) {
+        writeRam(ramAddr, (const uint8_t *)&t, sizeof(T));
+        return t;
+    }
+
+    /**
+     * @brief Low-level read call
+     *
+	 * @param ramAddr The address in the RTC RAM to read from
+	 *
+	 * @param data The buffer to read into
+	 *
+	 * @param dataLen The number of bytes to read
+	 *
+     * @param lock Whether to lock the I2C bus, the default is true. You pass false if you are grouping
+     * together functions in a single lock, for example doing a read/modify/write cycle.
+     * 
+	 * The dataLen can be larger than the maximum I2C read. Multiple reads will be done if necessary.
+     * However do not read past the end of RAM (address 255).
+     */
+	virtual bool readRam(size_t ramAddr, uint8_t *data, size_t dataLen, bool lock = true);
+
+    /**
+     * @brief Low-level write call
+     *
+	 * @param ramAddr The address in the RTC RAM to write to
+	 *
 	 * @param data The buffer containing the data to write
 	 *
 	 * @param dataLen The number of bytes to write
@@ -701,309 +2399,1185 @@ public:
      * @param lock Whether to lock the I2C bus, the default is true. You pass false if you are grouping
      * together functions in a single lock, for example doing a read/modify/write cycle.
      * 
-	 * The dataLen can be larger than the maximum I2C write. Multiple writes will be done if necessary.
-     * However do not read past the end of RAM (address 255).
+	 * The dataLen can be larger than the maximum I2C write. Multiple writes will be done if necessary.
+     * However do not read past the end of RAM (address 255).
+     */
+	virtual bool writeRam(size_t ramAddr, const uint8_t *data, size_t dataLen, bool lock = true);
+
+    /**
+     * @brief Utility function to convert a struct tm * to a readable string
+     * 
+     * @return String in the format of "yyyy-mm-dd hh:mm:ss". 
+     */
+    static String tmToString(const struct tm *timeptr);
+
+    /**
+     * @brief Convert a struct tm to register values for the AB1805
+     * 
+     * @param timeptr Pointer to a struct tm with the values to convert from
+     * 
+     * @param array Array of uint8_t to store the values to. This must be at least 6 bytes
+     * if includeYear is false or 7 if true. This points to the seconds field, not the
+     * hundredths field!
+     * 
+     * @param includeYear True if this is the the year should be included (time setting),
+     * or false if the year should not be included (alarm setting).
+     * 
+     * Note: Does not include the hundredths are struct tm doesn't include fractional seconds.
+     */
+    static void tmToRegisters(const struct tm *timeptr, uint8_t *array, bool includeYear);
+
+    /**
+     * @brief Convert register values to a struct tm
+     * 
+     * @param array Pointer to an array of values from the AB1805. Point to the seconds
+     * (not hundredths).
+     * 
+     * @param timeptr Pointer to a struct tm to hold the converted time
+     * 
+     * @param includeYear True if this is the the year should be included (time setting),
+     * or false if the year should not be included (alarm setting).
+     */
+    static void registersToTm(const uint8_t *array, struct tm *timeptr, bool includeYear);
+
+    /**
+     * @brief Convert RTC time register values directly to a time_t
+     * 
+     * @param array Pointer to an array of 6 values from the AB1805: seconds, minutes, hours,
+     * date, month, year. Point to the seconds (not hundredths). The weekday is not used.
+     * 
+     * @return The number of seconds since January 1, 1970 UTC. The year register is
+     * interpreted as 2000 - 2099.
+     * 
+     * This does not use struct tm or mktime, so it does not depend on the C library
+     * timezone setting and is safe to call from any thread.
+     */
+    static constexpr time_t registersToTime(const uint8_t *array) {
+        // Seconds, minutes, hours, date, month, year in bytes 0 - 5
+        uint64_t v = bcdBlockToValues(loadBlock(array, 6) & (TIME_BLOCK_FIELD_MASK >> 8));
+        return (time_t)daysFromCivil(2000 + (int)((v >> 40) & 0xff), (int)((v >> 32) & 0xff), (int)((v >> 24) & 0xff)) * 86400
+            + (int32_t)((v >> 16) & 0xff) * 3600 + (int32_t)((v >> 8) & 0xff) * 60 + (int32_t)(v & 0xff);
+    }
+
+    /**
+     * @brief Convert RTC time register values to milliseconds since January 1, 1970 UTC
+     *
+     * @param array Pointer to an array of 7 values from the AB1805: hundredths, seconds, minutes,
+     * hours, date, month, year. Point to the hundredths.
+     */
+    static constexpr uint64_t registersToMillis(const uint8_t *array) {
+        return (uint64_t)registersToTime(&array[1]) * 1000 + bcdToValue(array[0]) * 10;
+    }
+
+    /**
+     * @brief Convert a time_t directly to RTC time register values
+     * 
+     * @param time The number of seconds since January 1, 1970 UTC. Must be in the years
+     * 2000 - 2099 as the RTC only stores a two-digit year.
+     * 
+     * @param array Array of 7 bytes filled in with seconds, minutes, hours, date, month, 
+     * year, weekday. This points to the seconds field, not the hundredths field!
+     * 
+     * This does not use struct tm or gmtime, so it does not use shared static storage and
+     * is safe to call from any thread.
+     */
+    static constexpr void timeToRegisters(time_t time, uint8_t *array) {
+        int32_t days = (int32_t)(time / 86400);
+        int32_t secs = (int32_t)(time % 86400);
+
+        // civil_from_days by Howard Hinnant, simplified for dates after 1970
+        uint32_t z = (uint32_t)days + 719468;
+        uint32_t era = z / 146097;
+        uint32_t doe = z - era * 146097;
+        uint32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+        uint32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+        uint32_t mp = (5 * doy + 2) / 153;
+        uint32_t d = doy - (153 * mp + 2) / 5 + 1;
+        uint32_t m = (mp < 10) ? mp + 3 : mp - 9;
+        uint32_t y = yoe + era * 400 + (m <= 2);
+
+        uint64_t values = (uint64_t)(secs % 60) | ((uint64_t)((secs / 60) % 60) << 8) | ((uint64_t)(secs / 3600) << 16) |
+            ((uint64_t)d << 24) | ((uint64_t)m << 32) | ((uint64_t)(y % 100) << 40) | 
+            ((uint64_t)((days + 4) % 7) << 48); // January 1, 1970 was a Thursday (4)
+
+        storeBlock(valuesToBcdBlock(values), array, 7);
+    }
+
+    /**
+     * @brief Number of days from January 1, 1970 to a date
+     * 
+     * @param y Year (for example, 2020). Must be 1970 or later.
+     * 
+     * @param m Month 1 - 12
+     * 
+     * @param d Day of month 1 - 31
+     * 
+     * This is the days_from_civil algorithm by Howard Hinnant, simplified for dates after 1970.
+     */
+    static constexpr int32_t daysFromCivil(int y, int m, int d) {
+        uint32_t yy = (uint32_t)(y - (m <= 2));
+        uint32_t era = yy / 400;
+        uint32_t yoe = yy - era * 400;
+        uint32_t doy = (153 * (uint32_t)(m > 2 ? m - 3 : m + 9) + 2) / 5 + (uint32_t)d - 1;
+        uint32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+        return (int32_t)(era * 146097 + doe) - 719468;
+    }
+
+    /**
+     * @brief Convert a bcd value (0x00-0x99) into an integer (0-99)
+     */
+    static constexpr int bcdToValue(uint8_t bcd) {
+        return (bcd >> 4) * 10 + (bcd & 0x0f);
+    }
+
+    /**
+     * @brief Convert an integer value (0-99) into a bcd value (0x00 - 0x99)
+     */
+    static constexpr uint8_t valueToBcd(int value) {
+        return (uint8_t) ((((value / 10) % 10) << 4) | (value % 10));
+    }
+
+    /**
+     * @brief Decode the time registers REG_HUNDREDTH - REG_WEEKDAY to binary values in one operation
+     * 
+     * @param array 8 register values, starting at REG_HUNDREDTH
+     * 
+     * @param values Filled in with 8 binary values: hundredths, seconds, minutes, hours, date,
+     * month, year, weekday. The GP bits in the upper bits of the registers are removed.
+     * 
+     * @return true if every field is valid BCD and in range, or false if not, such as the 0xff
+     * values from a glitch on the I2C bus. values is filled in either way.
+     */
+    static constexpr bool decodeTimeBlock(const uint8_t *array, uint8_t *values) {
+        uint64_t bcd = loadBlock(array, 8) & TIME_BLOCK_FIELD_MASK;
+        storeBlock(bcdBlockToValues(bcd), values, 8);
+        return isValidBcdBlock(bcd) && isBlockInRange(bcdBlockToValues(bcd), TIME_BLOCK_MIN, TIME_BLOCK_MAX);
+    }
+
+    /**
+     * @brief Returns true if the time registers REG_HUNDREDTH - REG_WEEKDAY are valid BCD and in range
+     * 
+     * @param array 8 register values, starting at REG_HUNDREDTH
+     */
+    static constexpr bool isValidTimeBlock(const uint8_t *array) {
+        uint64_t bcd = loadBlock(array, 8) & TIME_BLOCK_FIELD_MASK;
+        return isValidBcdBlock(bcd) && isBlockInRange(bcdBlockToValues(bcd), TIME_BLOCK_MIN, TIME_BLOCK_MAX);
+    }
+
+    /**
+     * @brief Encode binary values to the time registers REG_HUNDREDTH - REG_WEEKDAY in one operation
+     * 
+     * @param values 8 binary values, 0 - 99: hundredths, seconds, minutes, hours, date, month, year, weekday
+     * 
+     * @param array Filled in with 8 register values, starting at REG_HUNDREDTH
+     */
+    static constexpr void encodeTimeBlock(const uint8_t *values, uint8_t *array) {
+        storeBlock(valuesToBcdBlock(loadBlock(values, 8)), array, 8);
+    }
+
+    /**
+     * @brief Decode the alarm registers REG_HUNDREDTH_ALARM - REG_WEEKDAY_ALARM to binary values in one operation
+     * 
+     * @param array 7 register values, starting at REG_HUNDREDTH_ALARM
+     * 
+     * @param values Filled in with 7 binary values: hundredths, seconds, minutes, hours, date, month,
+     * weekday. The GP bits in the upper bits of the registers are removed.
+     * 
+     * @return true if every field is valid BCD and in range, or false if not. values is filled in 
+     * either way. Date and month can be 0 as they're not used by all of the repeat modes.
+     */
+    static constexpr bool decodeAlarmBlock(const uint8_t *array, uint8_t *values) {
+        uint64_t bcd = loadBlock(array, 7) & ALARM_BLOCK_FIELD_MASK;
+        storeBlock(bcdBlockToValues(bcd), values, 7);
+        return isValidBcdBlock(bcd) && isBlockInRange(bcdBlockToValues(bcd), 0, ALARM_BLOCK_MAX);
+    }
+
+    /**
+     * @brief Encode binary values to the alarm registers REG_HUNDREDTH_ALARM - REG_WEEKDAY_ALARM in one operation
+     * 
+     * @param values 7 binary values, 0 - 99: hundredths, seconds, minutes, hours, date, month, weekday
+     * 
+     * @param array Filled in with 7 register values, starting at REG_HUNDREDTH_ALARM
+     */
+    static constexpr void encodeAlarmBlock(const uint8_t *values, uint8_t *array) {
+        storeBlock(valuesToBcdBlock(loadBlock(values, 7)), array, 7);
+    }
+
+    /**
+     * @brief Convert up to 8 packed BCD bytes (0x00 - 0x99) to binary (0 - 99), one per byte
+     * 
+     * There is no validation; use isValidBcdBlock() first.
+     */
+    static constexpr uint64_t bcdBlockToValues(uint64_t bcd) {
+        // tens * 10 + ones in each byte. The result is at most 165 so there's no carry into the next byte.
+        return ((bcd >> 4) & 0x0f0f0f0f0f0f0f0fULL) * 10 + (bcd & 0x0f0f0f0f0f0f0f0fULL);
+    }
+
+    /**
+     * @brief Convert up to 8 packed binary bytes (0 - 99) to BCD (0x00 - 0x99), one per byte
+     */
+    static constexpr uint64_t valuesToBcdBlock(uint64_t values) {
+        // Alternate bytes are spread into 16-bit lanes so the multiply can't carry into the next value.
+        // (v * 205) >> 11 is v / 10 for v < 1024, and BCD is v + 6 * (v / 10).
+        uint64_t even = values & 0x00ff00ff00ff00ffULL;
+        uint64_t odd = (values >> 8) & 0x00ff00ff00ff00ffULL;
+        uint64_t evenTens = ((even * 205) >> 11) & 0x000f000f000f000fULL;
+        uint64_t oddTens = ((odd * 205) >> 11) & 0x000f000f000f000fULL;
+        return (even + evenTens * 6) | ((odd + oddTens * 6) << 8);
+    }
+
+    /**
+     * @brief Returns true if both digits of up to 8 packed BCD bytes are 0 - 9
+     */
+    static constexpr bool isValidBcdBlock(uint64_t bcd) {
+        // Adding 6 to a digit carries into bit 4 if the digit is greater than 9
+        return ((((bcd & 0x0f0f0f0f0f0f0f0fULL) + 0x0606060606060606ULL) | 
+            (((bcd >> 4) & 0x0f0f0f0f0f0f0f0fULL) + 0x0606060606060606ULL)) & 0x1010101010101010ULL) == 0;
+    }
+
+    /**
+     * @brief Returns true if each of up to 8 packed binary bytes (0 - 99) is within a range
+     * 
+     * @param values Packed values, byte 0 is the first value
+     * 
+     * @param minValues Packed minimum values, 0 or 1
+     * 
+     * @param maxValues Packed maximum values, 0 - 99
+     */
+    static constexpr bool isBlockInRange(uint64_t values, uint64_t minValues, uint64_t maxValues) {
+        // Adding 0x7f - max sets bit 7 of bytes greater than max. Adding 0x80 - min clears 
+        // bit 7 of bytes less than min. Neither can carry into the next byte.
+        return (((values + (0x7f7f7f7f7f7f7f7fULL - maxValues)) | ~(values + (0x8080808080808080ULL - minValues))) & 0x8080808080808080ULL) == 0;
+    }
+
+    /**
+     * @brief Load up to 8 bytes into a uint64_t, array[0] in the least significant byte
+     */
+    static constexpr uint64_t loadBlock(const uint8_t *array, size_t num) {
+        uint64_t result = 0;
+        for(size_t ii = 0; ii < num; ii++) {
+            result |= (uint64_t)array[ii] << (8 * ii);
+        }
+        return result;
+    }
+
+    /**
+     * @brief Store up to 8 bytes from a uint64_t, the least significant byte in array[0]
+     */
+    static constexpr void storeBlock(uint64_t value, uint8_t *array, size_t num) {
+        for(size_t ii = 0; ii < num; ii++) {
+            array[ii] = (uint8_t)(value >> (8 * ii));
+        }
+    }
+
+    static const uint32_t RESET_PRESERVE_REPEATING_TIMER    = 0x00000001;   //!< When resetting registers, leave repeating timer settings intact
+    static const uint32_t RESET_DISABLE_XT                  = 0x00000002;   //!< When resetting registers, disable XT oscillator
+    
+    static const int WATCHDOG_MAX_SECONDS = 124;    //!< Maximum value that can be passed to setWDT().
+
+    static const size_t TIME_BLOCK_SIZE = 17;       //!< Number of bytes read by readTimeBlock(), REG_HUNDREDTH to REG_CTRL_1
+
+    static const uint64_t TIME_BLOCK_FIELD_MASK     = 0x07ff1f3f3f7f7fffULL; //!< Time bits of REG_HUNDREDTH - REG_WEEKDAY, REG_HUNDREDTH in the low byte. The rest are GP bits.
+    static const uint64_t TIME_BLOCK_MIN            = 0x0000010100000000ULL; //!< Minimum values of REG_HUNDREDTH - REG_WEEKDAY (date and month are 1)
+    static const uint64_t TIME_BLOCK_MAX            = 0x06630c1f173b3b63ULL; //!< Maximum values of REG_HUNDREDTH - REG_WEEKDAY (99, 59, 59, 23, 31, 12, 99, 6)
+    static const uint64_t ALARM_BLOCK_FIELD_MASK    = 0x00071f3f3f7f7fffULL; //!< Alarm bits of REG_HUNDREDTH_ALARM - REG_WEEKDAY_ALARM. The rest are GP bits.
+    static const uint64_t ALARM_BLOCK_MAX           = 0x00060c1f173b3b63ULL; //!< Maximum values of REG_HUNDREDTH_ALARM - REG_WEEKDAY_ALARM (99, 59, 59, 23, 31, 12, 6)
+
+
+    static const uint8_t REG_HUNDREDTH              = 0x00;      //!< Hundredths of a second, 2 BCD digits
+    static const uint8_t REG_SECOND                 = 0x01;      //!< Seconds, 2 BCD digits, MSB is GP0
+    static const uint8_t REG_MINUTE                 = 0x02;      //!< Minutes, 2 BCD digits, MSB is GP1
+    static const uint8_t REG_HOUR                   = 0x03;      //!< Hours, GP2, GP3
+    static const uint8_t REG_DATE                   = 0x04;      //!< Day of month (1-31), 2 BCD digits, GP4, GP5
+    static const uint8_t REG_MONTH                  = 0x05;      //!< Month (1-12), 2 BCD digits, GP6 - GP8
+    static const uint8_t REG_YEAR                   = 0x06;      //!< Year (0-99), 2 BCD digits
+    static const uint8_t REG_WEEKDAY                = 0x07;      //!< Weekday (0-6), GP9 - GP13
+    static const uint8_t REG_HUNDREDTH_ALARM        = 0x08;      //!< Alarm on hundredths of a second (0-99), 2 BCD digits
+    static const uint8_t REG_SECOND_ALARM           = 0x09;      //!< Alarm on seconds (0-59), 2 BCD digits, GP14
+    static const uint8_t REG_MINUTE_ALARM           = 0x0a;      //!< Alarm on minutes (0-59), 2 BCD digits, GP15
+    static const uint8_t REG_HOUR_ALARM             = 0x0b;      //!< Alarm on hour, GP16, GP17
+    static const uint8_t REG_DATE_ALARM             = 0x0c;      //!< Alarm on date (1-31), 2 BCD digits, GP18-GP19
+    static const uint8_t REG_MONTH_ALARM            = 0x0d;      //!< Alarm on month (1-12). 2 BCD digits, GP20-GP22
+    static const uint8_t REG_WEEKDAY_ALARM          = 0x0e;      //!< Alarm on day of week (0-6). GP23-GP27
+    static const uint8_t REG_STATUS                 = 0x0f;      //!< Status register
+    static const uint8_t   REG_STATUS_CB            = 0x80;      //!< Status register century bit mask
+    static const uint8_t   REG_STATUS_BAT           = 0x40;      //!< Status register switched to VBAT bit mask
+    static const uint8_t   REG_STATUS_WDT           = 0x20;      //!< Status register watchdog timer enabled and triggered bit mask
+    static const uint8_t   REG_STATUS_BL            = 0x10;      //!< Status register battery voltage crossing bit mask
+    static const uint8_t   REG_STATUS_TIM           = 0x08;      //!< Status register countdown timer reaches 0 bit mask
+    static const uint8_t   REG_STATUS_ALM           = 0x04;      //!< Status register alarm register match bit mask
+    static const uint8_t   REG_STATUS_EX2           = 0x02;      //!< Status register WDI interrupt bit mask
+    static const uint8_t   REG_STATUS_EX1           = 0x01;      //!< Status register EXTI interrupt bit mask
+    static const uint8_t   REG_STATUS_DEFAULT       = 0x00;      //!< Status register, default
+    static const uint8_t   EVENT_FLAGS_MASK         = 0x3f;      //!< Status register flags handled by processEvents() (WDT, BL, TIM, ALM, EX2, EX1)
+    static const uint8_t REG_CTRL_1                 = 0x10;      //!< Control register 1
+    static const uint8_t   REG_CTRL_1_STOP          = 0x80;      //!< Control register 1, stop clocking system
+    static const uint8_t   REG_CTRL_1_12_24         = 0x40;      //!< Control register 1, 12/24 hour mode select (0 = 24 hour)
+    static const uint8_t   REG_CTRL_1_OUTB          = 0x20;      //!< Control register 1, value for nIRQ2
+    static const uint8_t   REG_CTRL_1_OUT           = 0x10;      //!< Control register 1, value for FOUT/nIRQ
+    static const uint8_t   REG_CTRL_1_RSP           = 0x08;      //!< Control register 1, Reset polarity
+    static const uint8_t   REG_CTRL_1_ARST          = 0x04;      //!< Control register 1, Auto reset enable
+    static const uint8_t   REG_CTRL_1_PWR2          = 0x02;      //!< Control register 1, PWW/nIRQ pull-down enable
+    static const uint8_t   REG_CTRL_1_WRTC          = 0x01;      //!< Control register 1, write RTC mode
+    static const uint8_t   REG_CTRL_1_DEFAULT       = 0x13;      //!< Control register 1, 0b00010011 (OUT | RSO | PWR2 | WRTC)
+    static const uint8_t REG_CTRL_2                 = 0x11;      //!< Control register 2
+    static const uint8_t   REG_CTRL_2_RS1E          = 0x20;      //!< Control register 2, nIRQ2 output mode
+    static const uint8_t   REG_CTRL_2_OUT2S_MASK    = 0x1c;      //!< Control register 2, nIRQ2 output mode
+    static const uint8_t   REG_CTRL_2_OUT2S_nIRQ    = 0x00;      //!< Control register 2, nIRQ2 output mode, nIRQ or OUTB
+    static const uint8_t   REG_CTRL_2_OUT2S_SQW     = 0x04;      //!< Control register 2, nIRQ2 output mode, SQW or OUTB
+    static const uint8_t   REG_CTRL_2_OUT2S_nAIRQ   = 0x0c;      //!< Control register 2, nIRQ2 output mode, nAIRQ or OUTB
+    static const uint8_t   REG_CTRL_2_OUT2S_TIRQ    = 0x10;      //!< Control register 2, nIRQ2 output mode, TIRQ or OUTB
+    static const uint8_t   REG_CTRL_2_OUT2S_nTIRQ   = 0x14;      //!< Control register 2, nIRQ2 output mode, nTIRQ or OUTB
+    static const uint8_t   REG_CTRL_2_OUT2S_SLEEP   = 0x18;      //!< Control register 2, nIRQ2 output mode, sleep mode
+    static const uint8_t   REG_CTRL_2_OUT2S_OUTB    = 0x1c;      //!< Control register 2, nIRQ2 output mode, OUTB
+    static const uint8_t   REG_CTRL_2_OUT1S_MASK    = 0x03;      //!< Control register 2, FOUT/nIRQ output mode
+    static const uint8_t   REG_CTRL_2_OUT1S_nIRQ    = 0x00;      //!< Control register 2, FOUT/nIRQ output mode, nIRQ, or OUT
+    static const uint8_t   REG_CTRL_2_OUT1S_SQW     = 0x01;      //!< Control register 2, FOUT/nIRQ output mode, SQW or OUT
+    static const uint8_t   REG_CTRL_2_OUT1S_SQW_nIRQ= 0x02;      //!< Control register 2, FOUT/nIRQ output mode, SQW, nIRQ, or OUT
+    static const uint8_t   REG_CTRL_2_OUT1S_nAIRQ   = 0x03;      //!< Control register 2, FOUT/nIRQ output mode, nIRQ or OUT
+    static const uint8_t   REG_CTRL_2_DEFAULT       = 0x3c;      //!< Control register 2, 0b00111100 (OUT2S = OUTB)
+    static const uint8_t REG_INT_MASK               = 0x12;      //!< Interrupt mask
+    static const uint8_t   REG_INT_MASK_CEB         = 0x80;      //!< Interrupt mask, century enable
+    static const uint8_t   REG_INT_MASK_IM          = 0x60;      //!< Interrupt mask, interrupt mode bits (2 bits)
+    static const uint8_t   REG_INT_MASK_BLIE        = 0x10;      //!< Interrupt mask, battery low interrupt enable
+    static const uint8_t   REG_INT_MASK_TIE         = 0x08;      //!< Interrupt mask, timer interrupt enable
+    static const uint8_t   REG_INT_MASK_AIE         = 0x04;      //!< Interrupt mask, alarm interrupt enable
+    static const uint8_t   REG_INT_MASK_EX2E        = 0x02;      //!< Interrupt mask, XT2 interrupt enable
+    static const uint8_t   REG_INT_MASK_EX1E        = 0x01;      //!< Interrupt mask, XT1 interrupt enable
+    static const uint8_t   REG_INT_MASK_DEFAULT     = 0xe0;      //!< Interrupt mask, default 0b11100000 (CEB | IM=1/4 seconds)
+    static const uint8_t REG_SQW                    = 0x13;      //!< Square wave output control
+    static const uint8_t   REG_SQW_SQWE             = 0x80;      //!< Square wave output control, enable
+    static const uint8_t   REG_SQW_DEFAULT          = 0x26;      //!< Square wave output control, default 0b00100110
+    static const uint8_t REG_CAL_XT                 = 0x14;      //!< Calibration for the XT oscillator
+    static const uint8_t   REG_CAL_XT_CMDX          = 0x80;      //!< Calibration for the XT oscillator, coarse (1) or fine (0) adjustment
+    static const uint8_t   REG_CAL_XT_OFFSETX_MASK  = 0x7f;      //!< Calibration for the XT oscillator, OFFSETX (7-bit two's complement)
+    static const uint8_t REG_CAL_RC_HIGH            = 0x15;      //!< Calibration for the RC oscillator, upper 8 bits
+    static const uint8_t REG_CAL_RC_LOW             = 0x16;      //!< Calibration for the RC oscillator, lower 8 bits
+    static const uint8_t REG_SLEEP_CTRL             = 0x17;      //!< Power control system sleep function
+    static const uint8_t   REG_SLEEP_CTRL_SLP       = 0x80;      //!< Sleep control, enter sleep mode
+    static const uint8_t   REG_SLEEP_CTRL_SLRES     = 0x40;      //!< Sleep control, nRST low on sleep
+    static const uint8_t   REG_SLEEP_CTRL_EX2P      = 0x20;      //!< Sleep control, XT2 on rising WDI
+    static const uint8_t   REG_SLEEP_CTRL_EX1P      = 0x10;      //!< Sleep control, XT1 on rising EXTI
+    static const uint8_t   REG_SLEEP_CTRL_SLST      = 0x08;      //!< Sleep control, set when sleep has occurred
+    static const uint8_t   REG_SLEEP_CTRL_SLTO_MASK = 0x07;      //!< Sleep control, number of 7.8ms periods before sleep
+    static const uint8_t   REG_SLEEP_CTRL_DEFAULT   = 0x00;      //!< Sleep control default (0b00000000)
+    static const uint8_t REG_TIMER_CTRL             = 0x18;      //!< Countdown timer control 
+    static const uint8_t   REG_TIMER_CTRL_TE        = 0x80;      //!< Countdown timer control, timer enable 
+    static const uint8_t   REG_TIMER_CTRL_TM        = 0x40;      //!< Countdown timer control, timer interrupt mode
+    static const uint8_t   REG_TIMER_CTRL_TRPT      = 0x20;      //!< Countdown timer control, timer repeat function
+    static const uint8_t   REG_TIMER_CTRL_RPT_MASK  = 0x1c;      //!< Countdown timer control, repeat function
+    static const uint8_t   REG_TIMER_CTRL_RPT_HUN   = 0x1c;      //!< Countdown timer control, repeat hundredths match (7)
+    static const uint8_t   REG_TIMER_CTRL_RPT_SEC   = 0x18;      //!< Countdown timer control, repeat hundredths, seconds match (once per minute) (6)
+    static const uint8_t   REG_TIMER_CTRL_RPT_MIN   = 0x14;      //!< Countdown timer control, repeat hundredths, seconds, minutes match (once per hour) (5)
+    static const uint8_t   REG_TIMER_CTRL_RPT_HOUR  = 0x10;      //!< Countdown timer control, repeat hundredths, seconds, minutes, hours match (once per day) (4)
+    static const uint8_t   REG_TIMER_CTRL_RPT_WKDY  = 0x0c;      //!< Countdown timer control, repeat hundredths, seconds, minutes, hours, weekday match (once per week) (3)
+    static const uint8_t   REG_TIMER_CTRL_RPT_DATE  = 0x08;      //!< Countdown timer control, repeat hundredths, seconds, minutes, hours, date match (once per month) (2)
+    static const uint8_t   REG_TIMER_CTRL_RPT_MON   = 0x04;      //!< Countdown timer control, repeat hundredths, seconds, minutes, hours, date, month match (once per year) (1)
+    static const uint8_t   REG_TIMER_CTRL_RPT_DIS   = 0x00;      //!< Countdown timer control, alarm disabled (0)
+    static const uint8_t   REG_TIMER_CTRL_TFS_MASK  = 0x03;      //!< Countdown timer control, clock frequency
+    static const uint8_t   REG_TIMER_CTRL_TFS_FAST  = 0x00;      //!< Countdown timer control, clock frequency 4.096 kHz or 128 Hz
+    static const uint8_t   REG_TIMER_CTRL_TFS_64    = 0x01;      //!< Countdown timer control, clock frequency 64 Hz
+    static const uint8_t   REG_TIMER_CTRL_TFS_1     = 0x02;      //!< Countdown timer control, clock frequency 1 Hz
+    static const uint8_t   REG_TIMER_CTRL_TFS_1_60  = 0x03;      //!< Countdown timer control, clock frequency 1/60 Hz (1 minute)
+    static const uint8_t   REG_TIMER_CTRL_DEFAULT   = 0x23;      //!< Countdown timer control, 0b00100011 (TFPT + TFS = 1/60 Hz0)
+    static const uint8_t REG_TIMER                  = 0x19;      //!< Countdown timer current value register
+    static const uint8_t   REG_TIMER_DEFAULT        = 0x00;      //!< Countdown timer current value register default value (0x00)
+    static const uint8_t REG_TIMER_INITIAL          = 0x1a;      //!< Countdown timer inital (reload) value register
+    static const uint8_t   REG_TIMER_INITIAL_DEFAULT= 0x00;      //!< Countdown timer inital value register default value 
+    static const uint8_t REG_WDT                    = 0x1b;      //!< Watchdog timer control register
+    static const uint8_t   REG_WDT_RESET            = 0x80;      //!< Watchdog timer control, enable reset (1) or WIRQ (0)
+    static const uint8_t   REG_WDT_WRB_16_HZ        = 0x00;      //!< Watchdog timer control, WRB watchdog clock = 16 Hz
+    static const uint8_t   REG_WDT_WRB_4_HZ         = 0x01;      //!< Watchdog timer control, WRB watchdog clock = 4 Hz
+    static const uint8_t   REG_WDT_WRB_1_HZ         = 0x02;      //!< Watchdog timer control, WRB watchdog clock = 1 Hz
+    static const uint8_t   REG_WDT_WRB_1_4_HZ       = 0x03;      //!< Watchdog timer control, WRB watchdog clock = 1/4 Hz
+    static const uint8_t   REG_WDT_DEFAULT          = 0x00;      //!< Watchdog timer control, default value
+    static const uint8_t REG_OSC_CTRL               = 0x1c;      //!< Oscillator control register
+    static const uint8_t   REG_OSC_CTRL_OSEL        = 0x80;      //!< Oscillator control, clock select 32.768 kHz (0) or 128 Hz (1)
+    static const uint8_t   REG_OSC_CTRL_ACAL        = 0x60;      //!< Oscillator control, auto-calibration
+    static const uint8_t   REG_OSC_CTRL_AOS         = 0x10;      //!< Oscillator control, automatic switch to RC oscillator on battery
+    static const uint8_t   REG_OSC_CTRL_FOS         = 0x08;      //!< Oscillator control, automatic switch to RC oscillator on failure
+    static const uint8_t   REG_OSC_CTRL_PWGT        = 0x04;      //!< Oscillator control, IO interface disable
+    static const uint8_t   REG_OSC_CTRL_OFIE        = 0x02;      //!< Oscillator control, oscillator fail interrupt enable
+    static const uint8_t   REG_OSC_CTRL_ACIE        = 0x01;      //!< Oscillator control, auto-calibration fail interrupt enable
+    static const uint8_t   REG_OSC_CTRL_DEFAULT     = 0x00;      //!< Oscillator control, default value
+    static const uint8_t REG_OSC_STATUS             = 0x1d;      //!< Oscillator status register
+    static const uint8_t   REG_OSC_STATUS_XTCAL     = 0xc0;      //!< Oscillator status register, extended crystal calibration
+    static const uint8_t   REG_OSC_STATUS_XTCAL_SHIFT = 6;       //!< Oscillator status register, extended crystal calibration bit offset
+    static const uint8_t   REG_OSC_STATUS_LKO2      = 0x04;      //!< Oscillator status register, lock OUT2
+    static const uint8_t   REG_OSC_STATUS_OMODE     = 0x01;      //!< Oscillator status register, oscillator mode (read-only)
+    static const uint8_t   REG_OSC_STATUS_OF        = 0x02;      //!< Oscillator status register, oscillator failure
+    static const uint8_t   REG_OSC_STATUS_ACF       = 0x01;      //!< Oscillator status register, auto-calibration failure
+    static const uint8_t REG_CONFIG_KEY             = 0x1f;      //!< Register to set to modify certain other keys
+    static const uint8_t   REG_CONFIG_KEY_OSC_CTRL  = 0xa1;      //!< Configuration key, enable setting REG_OSC_CTRL
+    static const uint8_t   REG_CONFIG_KEY_SW_RESET  = 0x3c;      //!< Configuration key, software reset
+    static const uint8_t   REG_CONFIG_KEY_OTHER     = 0x9d;      //!< Configuration key, REG_TRICKLE, REG_BREF_CTRL, REG_AFCTRL, REG_BATMODE_IO, REG_OCTRL
+    static const uint8_t REG_TRICKLE                = 0x20;      //!< Trickle charger control register
+    static const uint8_t   REG_TRICKLE_DEFAULT      = 0x00;      //!< Trickle charger control register, default value
+    static const uint8_t   REG_TRICKLE_TCS_MASK     = 0xf0;      //!< Trickle charger control register, enable mask
+    static const uint8_t   REG_TRICKLE_TCS_ENABLE   = 0xa0;      //!< Trickle charger control register, enable value (0b10100000)
+    static const uint8_t   REG_TRICKLE_DIODE_MASK   = 0x0c;      //!< Trickle charger control register, diode mask
+    static const uint8_t   REG_TRICKLE_DIODE_0_6    = 0x08;      //!< Trickle charger control register, diode 0.6V drop
+    static const uint8_t   REG_TRICKLE_DIODE_0_3    = 0x04;      //!< Trickle charger control register, diode 0.3V drop
+    static const uint8_t   REG_TRICKLE_ROUT_MASK    = 0x03;      //!< Trickle charger control register, rout mask
+    static const uint8_t   REG_TRICKLE_ROUT_11K     = 0x03;      //!< Trickle charger control register, rout 11K
+    static const uint8_t   REG_TRICKLE_ROUT_6K      = 0x02;      //!< Trickle charger control register, rout 6K
+    static const uint8_t   REG_TRICKLE_ROUT_3K      = 0x01;      //!< Trickle charger control register, rout 3K
+    static const uint8_t   REG_TRICKLE_ROUT_DISABLE = 0x00;      //!< Trickle charger control register, rout disable
+    static const uint8_t REG_BREF_CTRL              = 0x21;      //!< Wakeup control system reference voltages
+    static const uint8_t   REG_BREF_CTRL_DEFAULT    = 0xf0;      //!< Wakeup control system default 0b11110000
+    static const uint8_t   REG_BREF_CTRL_25_30      = 0x70;      //!< Wakeup control falling 2.5V rising 3.0V
+    static const uint8_t   REG_BREF_CTRL_21_25      = 0xb0;      //!< Wakeup control falling 2.1V rising 2.5V
+    static const uint8_t   REG_BREF_CTRL_18_22      = 0xd0;      //!< Wakeup control falling 1.8V rising 2.2V
+    static const uint8_t   REG_BREF_CTRL_14_16      = 0xf0;      //!< Wakeup control falling 1.4V rising 1.6V, default value
+    static const uint8_t REG_AFCTRL                 = 0x26;      //!< Auto-calibration filter capacitor enable register
+    static const uint8_t   REG_AFCTRL_ENABLE        = 0xa0;      //!< Auto-calibration filter capacitor enable
+    static const uint8_t   REG_AFCTRL_DISABLE       = 0x00;      //!< Auto-calibration filter capacitor disable
+    static const uint8_t   REG_AFCTRL_DEFAULT       = 0x00;      //!< Auto-calibration filter, default
+    static const uint8_t REG_BATMODE_IO             = 0x27;      //!< Brownout control for IO interface
+    static const uint8_t   REG_BATMODE_IO_DEFAULT   = 0x80;      //!< Brownout control for IO interface, default value
+    static const uint8_t   REG_BATMODE_IO_IOBM      = 0x80;      //!< Brownout control for IO interface, enable IO when on VBAT
+    static const uint8_t REG_ID0                    = 0x28;      //!< Part number, upper (read-only)
+    static const uint8_t   REG_ID0_AB08XX           = 0x18;      //!< Part number, upper, AB08xx
+    static const uint8_t   REG_ID0_AB18XX           = 0x18;      //!< Part number, upper, AB18xx
+    static const uint8_t REG_ID1                    = 0x29;      //!< Part number, lower (read-only)
+    static const uint8_t   REG_ID1_ABXX05           = 0x05;      //!< Part number, lower, AB1805 or AB0805 (I2C)
+    static const uint8_t   REG_ID1_ABXX15           = 0x05;      //!< Part number, lower, AB1815 or AB0815 (SPI)
+    static const uint8_t REG_ID2                    = 0x2a;      //!< Part revision (read-only)
+    static const uint8_t REG_ID3                    = 0x2b;      //!< Lot number, lower (read-only)
+    static const uint8_t REG_ID4                    = 0x2c;      //!< Manufacturing unique ID upper (read-only)
+    static const uint8_t REG_ID5                    = 0x2d;      //!< Manufacturing unique ID lower (read-only)
+    static const uint8_t REG_ID6                    = 0x2e;      //!< Lot and wafer information (read-only)
+    static const uint8_t REG_ASTAT                  = 0x2f;      //!< Analog status register (read-only)
+    static const uint8_t   REG_ASTAT_BBOD           = 0x80;      //!< Analog status register. VBAT is above BREF (read-only)
+    static const uint8_t   REG_ASTAT_BMIN           = 0x40;      //!< Analog status register. VBAT is above minimum operating voltage 1.2V (read-only)
+    static const uint8_t   REG_ASTAT_VINIT          = 0x02;      //!< Analog status register. VCC is about minimum 1.6V (read-only)
+    static const uint8_t REG_OCTRL                  = 0x30;      //!< Output control register at power-down
+    static const uint8_t   REG_OCTRL_WDBM           = 0x80;      //!< Output control register, WDI enabled when powered from VBAT
+    static const uint8_t   REG_OCTRL_EXBM           = 0x40;      //!< Output control register, EXTI enabled when powered from VBAT
+    static const uint8_t   REG_OCTRL_WDDS           = 0x20;      //!< Output control register, WDI disabled in sleep 
+    static const uint8_t   REG_OCTRL_EXDS           = 0x10;      //!< Output control register, EXTI disabled in sleep
+    static const uint8_t   REG_OCTRL_RSEN           = 0x08;      //!< Output control register, nRST output enabled in sleep
+    static const uint8_t   REG_OCTRL_O4EN           = 0x04;      //!< Output control register, CLKOUT/nIRQ3 enabled in sleep
+    static const uint8_t   REG_OCTRL_O3EN           = 0x02;      //!< Output control register, nTIRQ enabled in sleep
+    static const uint8_t   REG_OCTRL_O1EN           = 0x01;      //!< Output control register, FOUT/nIRQ enabled in sleep 
+    static const uint8_t   REG_OCTRL_DEFAULT        = 0x00;      //!< Output control register, default 
+    static const uint8_t REG_EXT_ADDR               = 0x3f;      //!< Extension RAM address
+    static const uint8_t   REG_EXT_ADDR_O4MB        = 0x80;      //!< Extension RAM address, CLKOUT/nIRQ3 enabled when powered from VBAT
+    static const uint8_t   REG_EXT_ADDR_BPOL        = 0x40;      //!< Extension RAM address, BL polarity
+    static const uint8_t   REG_EXT_ADDR_WDIN        = 0x20;      //!< Extension RAM address, level of WDI pin (read-only)
+    static const uint8_t   REG_EXT_ADDR_EXIN        = 0x10;      //!< Extension RAM address, level of EXTI pin (read-only)
+    static const uint8_t   REG_EXT_ADDR_XADA        = 0x04;      //!< Extension RAM address, Upper bit of alternate RAM address
+    static const uint8_t   REG_EXT_ADDR_XADS        = 0x03;      //!< Extension RAM address, Upper 2 bits of standard RAM address
+    static const uint8_t REG_RAM                    = 0x40;      //!< Standard RAM
+    static const uint8_t REG_ALT_RAM                = 0x80;      //!< Alternate RAM address
+
+
+protected:
+    /**
+     * @brief Internal function used to handle system events
+     * 
+     * We currently only handle the reset event to disable the WDT before reset so it
+     * won't trigger during a OTA firmware update.
+     */
+    void systemEvent(system_event_t event, int param);
+
+    /**
+     * @brief Static function passed to System.on
+     * 
+     * AB1805 is a singleton so AB1805::instance is used to find the instance pointer.
+     */
+    static void systemEventStatic(system_event_t event, int param);
+
+    /**
+     * @brief Load the timer queue from the RTC RAM. Called from setup() when withAlarmTimers() is used.
+     */
+    bool loadAlarmTimers();
+
+    /**
+     * @brief Save the timer queue to the RTC RAM and set the alarm to the next wake time
+     * 
+     * Does nothing while serviceAlarmTimers() is calling handlers, as it's done once at the end.
+     */
+    bool updateAlarmTimers();
+
+    /**
+     * @brief Returns the index in the queue of the timer with id, or -1 if not found
+     */
+    int findAlarmTimer(uint8_t id) const;
+
+    /**
+     * @brief Remove the timer at index from the queue
+     */
+    void removeAlarmTimerAt(size_t index);
+
+    /**
+     * @brief Move the timer at index toward the top of the heap until its parent expires earlier
+     */
+    void alarmTimerSiftUp(size_t index);
+
+    /**
+     * @brief Move the timer at index toward the bottom of the heap until its children expire later
+     */
+    void alarmTimerSiftDown(size_t index);
+
+    /**
+     * @brief Interrupt service routine for FOUT/nIRQ, used by withEventInterrupt()
+     */
+    void foutInterrupt();
+
+    /**
+     * @brief Read the cacheable registers from the chip into the shadow register cache
+     *
+     * Called from setup() when the cache is enabled. Uses burst reads.
+     */
+    bool loadRegisterCache();
+
+    /**
+     * @brief Copies registers from the shadow register cache
+     *
+     * @return true if every register in the range was cacheable and valid, in which case
+     * array is filled in. Otherwise returns false and array is not modified.
+     */
+    bool readRegisterCache(uint8_t regAddr, uint8_t *array, size_t num) const;
+
+    /**
+     * @brief Updates the shadow register cache after a successful read or write
+     *
+     * @param isWrite true if the values were written to the chip. Writes to key-protected
+     * registers are only cached when the correct key was written immediately before.
+     */
+    void updateRegisterCache(uint8_t regAddr, const uint8_t *array, size_t num, bool isWrite);
+
+    /**
+     * @brief Load the calibration state from the RTC RAM and apply the saved adjustment
+     *
+     * Called from setup() when calibration is enabled.
+     */
+    bool loadCalibration();
+
+    /**
+     * @brief Save the calibration state to the RTC RAM
+     */
+    bool saveCalibration();
+
+    /**
+     * @brief Remove a step in the RTC time from the calibration samples
+     *
+     * @param stepMs The new RTC time minus the old RTC time at the moment it was set, in milliseconds
+     */
+    void calibrationRtcStep(int64_t stepMs);
+
+    static const uint8_t REG_CACHE_FIRST = 0x10;    //!< First register in the shadow register cache (REG_CTRL_1)
+    static const uint8_t REG_CACHE_LAST = 0x30;     //!< Last register in the shadow register cache (REG_OCTRL)
+    static const size_t REG_CACHE_SIZE = REG_CACHE_LAST - REG_CACHE_FIRST + 1; //!< Number of bytes in the cache
+
+    /**
+     * @brief Registers in the cache range that are never cached, as a bit mask of (regAddr - REG_CACHE_FIRST)
+     *
+     * REG_SLEEP_CTRL (0x17), REG_TIMER_CTRL (0x18), REG_TIMER (0x19), REG_WDT (0x1b), REG_OSC_STATUS (0x1d),
+     * 0x1e, REG_CONFIG_KEY (0x1f), and REG_ASTAT (0x2f).
+     */
+    static const uint64_t REG_CACHE_VOLATILE_MASK =
+        (1ULL << (0x17 - REG_CACHE_FIRST)) | (1ULL << (0x18 - REG_CACHE_FIRST)) | (1ULL << (0x19 - REG_CACHE_FIRST)) |
+        (1ULL << (0x1b - REG_CACHE_FIRST)) | (1ULL << (0x1d - REG_CACHE_FIRST)) | (1ULL << (0x1e - REG_CACHE_FIRST)) |
+        (1ULL << (0x1f - REG_CACHE_FIRST)) | (1ULL << (0x2f - REG_CACHE_FIRST));
+
+    /**
+     * @brief Which I2C (TwoWire) interface to use. Usually Wire, is Wire1 on Tracker SoM
+     */
+    TwoWire &wire = Wire; 
+
+    /**
+     * @brief I2C address, always 0x69 as that is the address hardwired in the AB1805
+     */
+    uint8_t i2cAddr = 0x69;
+
+    /**
+     * @brief Which GPIO is connected to FOUT/nIRQ
+     * 
+     * Set to PIN_INVALID if not connected. 
+     * 
+     * This is used for interrupts, and also to detect if the AB1805 is alive, during
+     * detectChip(). If not connected, then only I2C is used to detect the chip.
+     */
+    pin_t foutPin = PIN_INVALID;
+
+    /**
+     * @brief Actual watchdog period in milliseconds (62 <= watchdogMillis <= 124000) or 0 for disabled.
+     * 
+     * This is used so setWDT(-1) can restore the previous value.
+     */
+    uint32_t watchdogMillis = 0;
+
+    /**
+     * @brief The REG_WDT value for watchdogMillis, used to service the watchdog
+     */
+    uint8_t watchdogRegValue = 0;
+
+    /**
+     * @brief Called from the software timer for withWatchdogRefreshTimer()
+     * 
+     * Software timers share one thread with a small stack, so this only samples the state in memory and 
+     * does at most a single write to REG_WDT. Logging and saving to the RTC RAM are done from AB1805::loop(),
+     * and the watchdog snapshot from the watchdog thread.
+     */
+    void watchdogTimerCallback();
+
+    /**
+     * @brief Write the watchdog duration, used by setWDTMillis() and the watchdog budgets
+     * 
+     * Unlike setWDTMillis(), this does not change the duration restored when the last budget phase ends.
+     */
+    bool writeWDTMillis(uint32_t ms);
+
+    /**
+     * @brief Thread function for withWatchdogSnapshot(), calls serviceWatchdogThread() periodically. Never returns.
+     */
+    void watchdogThreadFunction();
+
+    /**
+     * @brief Handle requests from watchdogTimerCallback() that need I2C transactions
+     */
+    void serviceWatchdogThread();
+
+    /**
+     * @brief Thread for withWatchdogSnapshot(), allocated in setup(). It's not deleted as the thread never exits.
+     */
+    Thread *watchdogThread = nullptr;
+
+    /**
+     * @brief Set by watchdogTimerCallback() to have the watchdog thread save the snapshot, WatchdogSnapshot flags or 0
+     */
+    volatile uint8_t watchdogSnapshotFlags = 0;
+
+    /**
+     * @brief Set by watchdogTimerCallback() to have the watchdog thread clear a stale WDT flag
+     */
+    volatile bool watchdogClearWdtRequest = false;
+
+    /**
+     * @brief True if withWatchdogRefreshTimer() was used
+     */
+    bool watchdogTimerEnabled = false;
+
+    /**
+     * @brief Maximum time between calls to loop() for the watchdog to be serviced from the timer, or 0
+     */
+    unsigned long watchdogLoopTimeout = 0;
+
+    /**
+     * @brief The millis() value of the last call to loop()
+     */
+    volatile unsigned long loopMillis = 0;
+
+    /**
+     * @brief Software timer for withWatchdogRefreshTimer(), allocated in setup()
+     */
+    Timer *watchdogTimer = nullptr;
+
+    /**
+     * @brief Read and clear the WatchdogSnapshot, from setup()
+     */
+    bool loadWatchdogSnapshot();
+
+    /**
+     * @brief Called from the timer when the watchdog was not serviced for the watchdog duration. Saves the snapshot and arms the reset.
+     * 
+     * @param flags WATCHDOG_SNAPSHOT_LOOP_HUNG or WATCHDOG_SNAPSHOT_CLIENT_LATE
+     */
+    bool checkWatchdogInterrupt(uint8_t flags);
+
+    /**
+     * @brief True if withWatchdogSnapshot() was used
+     */
+    bool snapshotEnabled = false;
+
+    /**
+     * @brief Address in RTC RAM of the WatchdogSnapshot
+     */
+    size_t snapshotRamAddr = 0;
+
+    /**
+     * @brief The WatchdogSnapshot read in setup(), magic is 0 if there was none
+     */
+    WatchdogSnapshot watchdogSnapshot = {};
+
+    /**
+     * @brief True after the snapshot is saved and the watchdog is set to reset, so refreshWDT() does nothing
+     */
+    bool watchdogResetArmed = false;
+
+    /**
+     * @brief The millis() value of the last successful write to REG_WDT by setWDTMillis() or refreshWDT()
+     */
+    volatile uint32_t watchdogRefreshMillis = 0;
+
+    /**
+     * @brief Set by watchdogCheckpoint()
+     */
+    volatile uint32_t checkpointAddr = 0;
+
+    /**
+     * @brief Set by watchdogCheckpoint()
+     */
+    volatile uint16_t checkpointId = 0;
+
+    /**
+     * @brief Ids of the last 4 calls to watchdogHeartbeat(), most recent in the low byte
+     */
+    volatile uint32_t heartbeatIds = 0;
+
+    /**
+     * @brief millis() when each watchdog budget phase started
+     */
+    uint32_t watchdogPhaseStart[WATCHDOG_PHASE_MAX] = {};
+
+    /**
+     * @brief Budget in milliseconds of each watchdog budget phase
+     */
+    uint32_t watchdogPhaseBudget[WATCHDOG_PHASE_MAX] = {};
+
+    /**
+     * @brief Durations of each watchdog budget phase
+     */
+    WatchdogPhaseStats watchdogPhaseStats[WATCHDOG_PHASE_MAX] = {};
+
+    /**
+     * @brief Bit mask of active watchdog budget phases
+     */
+    volatile uint8_t watchdogPhaseActive = 0;
+
+    /**
+     * @brief watchdogMillis before the duration was increased for a budget, or 0 if not increased
+     * 
+     * Also updated by setWDTMillis() during a phase, so the application's duration is the one restored.
+     */
+    uint32_t watchdogBudgetSavedMillis = 0;
+
+    /**
+     * @brief Budgets set by withSystemWatchdogBudgets(), indexed by phase
+     */
+    uint32_t systemWatchdogBudget[WATCHDOG_PHASE_USER] = {};
+
+    /**
+     * @brief The last millis() value where AB1805::loop() serviced the watchdog
+     */
+    unsigned long lastWatchdogMillis = 0;
+
+    /**
+     * @brief How often to call updateWDT(-1) in milliseconds
+     */
+    unsigned long watchdogUpdatePeriod = 0;
+
+    /**
+     * @brief Read the supervisor state from the RTC RAM, from setup()
+     */
+    bool loadWatchdogSupervisor();
+
+    /**
+     * @brief True if withWatchdogSupervisor() was used
+     */
+    bool supervisorEnabled = false;
+
+    /**
+     * @brief Address in RTC RAM of the WatchdogSupervisorState
+     */
+    size_t supervisorRamAddr = 0;
+
+    /**
+     * @brief Copy of the WatchdogSupervisorState in RTC RAM
+     */
+    WatchdogSupervisorState supervisorState = {};
+
+    /**
+     * @brief Deadline in milliseconds for each client, or 0 if not registered
+     */
+    uint32_t watchdogClientDeadline[WATCHDOG_CLIENT_MAX] = {};
+
+    /**
+     * @brief The millis() value of the last heartbeat for each client, set from any thread
+     */
+    volatile uint32_t watchdogClientHeartbeat[WATCHDOG_CLIENT_MAX] = {};
+
+    /**
+     * @brief Bit mask of clients that have missed their deadline and are counted already
+     */
+    uint8_t watchdogClientLate = 0;
+
+    /**
+     * @brief Bit mask of clients that missed their deadline and have not been logged yet
+     */
+    volatile uint8_t watchdogClientNewlyLate = 0;
+
+    /**
+     * @brief True if supervisorState has changed and needs to be saved in the RTC RAM
+     */
+    volatile bool supervisorStateChanged = false;
+
+    /**
+     * @brief Update the late clients and miss counters in memory, without logging or I2C, and return true if all are healthy
+     * 
+     * This is used from the software timer. Call saveWatchdogSupervisor() to save the changes.
+     */
+    bool updateWatchdogClients();
+
+    /**
+     * @brief Log newly late clients and save supervisorState in the RTC RAM if it changed
+     */
+    bool saveWatchdogSupervisor();
+
+    /**
+     * @brief Client that stopped the watchdog refresh before the last reset, or -1
+     */
+    int watchdogStarvedClient = -1;
+
+    /**
+     * @brief True if we've set the RTC from the cloud time
+     */
+    bool timeSet = false;
+
+    /**
+     * @brief Use setRtcFromSystemAligned() from loop() (see withAlignedRtcSet())
+     */
+    bool alignedRtcSet = false;
+
+    /**
+     * @brief The reason for wake. Set during setup()
+     */
+    WakeReason wakeReason = WakeReason::UNKNOWN;
+
+    /**
+     * @brief Bit mask of WAKE_CAUSE_* values. Set by updateWakeReason()
+     */
+    uint16_t wakeCauses = 0;
+
+    /**
+     * @brief Read the boot journal header and increment the boot count, from setup()
+     */
+    bool loadBootJournal();
+
+    /**
+     * @brief Add a record to the boot journal, from updateWakeReason()
+     * 
+     * @param status Raw REG_STATUS
+     * 
+     * @param sleepCtrl Raw REG_SLEEP_CTRL
+     */
+    bool addBootJournalRecord(uint8_t status, uint8_t sleepCtrl);
+
+    /**
+     * @brief True if withBootJournal() was used
+     */
+    bool bootJournalEnabled = false;
+
+    /**
+     * @brief Address in RTC RAM of the BootJournalHeader
+     */
+    size_t bootJournalRamAddr = 0;
+
+    /**
+     * @brief Capacity passed to withBootJournal()
+     */
+    uint8_t bootJournalCapacity = 0;
+
+    /**
+     * @brief Copy of the BootJournalHeader in RTC RAM, magic is 0 if not loaded
+     */
+    BootJournalHeader bootJournalHeader = {};
+
+    /**
+     * @brief True if software timers on the alarm are enabled (see withAlarmTimers())
+     */
+    bool alarmTimersEnabled = false;
+
+    /**
+     * @brief True while serviceAlarmTimers() is calling handlers
+     */
+    bool alarmTimersServicing = false;
+
+    /**
+     * @brief Address in the RTC RAM of the AlarmTimerQueue
+     */
+    size_t alarmTimerRamAddr = 0;
+
+    /**
+     * @brief The wake time the hardware alarm is set to, or 0 if not set
+     */
+    uint32_t alarmTimerArmed = 0;
+
+    /**
+     * @brief Set the countdown timer for the first segment of ms
+     * 
+     * @param ms The remaining duration in milliseconds
+     * 
+     * If this is the last segment, countdownTimerMs is cleared so the TIM event is passed to the handlers.
+     */
+    bool startCountdownTimerSegment(uint32_t ms);
+
+    /**
+     * @brief Called from processEvents() on TIM to start the next segment of setCountdownTimerMillis()
+     * 
+     * @return true if another segment was started, or false if the duration is done
+     */
+    bool continueCountdownTimer();
+
+    /**
+     * @brief Common code for deepPowerDown(), deepPowerDownFor(), and deepPowerDownUntil()
+     * 
+     * @param wake How to wake
+     * 
+     * @param seconds For the countdown timer, the duration in seconds
+     * 
+     * @param wakeTime For the alarm, the RTC time to wake
+     */
+    bool enterDeepPowerDown(DeepPowerDownWake wake, uint32_t seconds, time_t wakeTime);
+
+    /**
+     * @brief Read and clear the DeepPowerDownRecord, from setup()
+     */
+    bool loadDeepPowerDownRecord();
+
+    /**
+     * @brief True if withDeepPowerDownRecord() was used
+     */
+    bool deepPowerDownRecordEnabled = false;
+
+    /**
+     * @brief Address in RTC RAM of the DeepPowerDownRecord
+     */
+    size_t deepPowerDownRamAddr = 0;
+
+    /**
+     * @brief The DeepPowerDownRecord read in setup(), magic is 0 if there was none
+     */
+    DeepPowerDownRecord deepPowerDownRecord = {};
+
+    /**
+     * @brief The RTC time when the DeepPowerDownRecord was read
+     */
+    time_t deepPowerDownActualWake = 0;
+
+    /**
+     * @brief Total duration for setCountdownTimerMillis(), or 0 if there are no more segments
+     */
+    uint32_t countdownTimerMs = 0;
+
+    /**
+     * @brief The millis() value when setCountdownTimerMillis() was called
+     */
+    unsigned long countdownTimerStart = 0;
+
+    /**
+     * @brief Function to call when a timer expires
+     */
+    AlarmTimerHandler alarmTimerHandler;
+
+    /**
+     * @brief Set the alarm for scheduleNext
+     */
+    bool armSchedule();
+
+    /**
+     * @brief True if setSchedule() is used
+     */
+    bool scheduleEnabled = false;
+
+    /**
+     * @brief The schedule set with setSchedule()
+     */
+    Schedule schedule = {};
+
+    /**
+     * @brief Hardware repeat mode that matches the schedule, or REG_TIMER_CTRL_RPT_DIS
+     */
+    uint8_t scheduleRpt = 0;
+
+    /**
+     * @brief The next scheduled time, or 0 if there is no schedule
+     */
+    time_t scheduleNext = 0;
+
+    /**
+     * @brief Number of alarms that did not match the schedule
+     */
+    uint32_t scheduleFilteredWakes = 0;
+
+    /**
+     * @brief The scheduled time that the handler was last called for, or 0
+     */
+    time_t scheduleLast = 0;
+
+    /**
+     * @brief Function to call at each scheduled time
+     */
+    ScheduleHandler scheduleHandler;
+
+    /**
+     * @brief The millis() value when the awake time was last added to the timer statistics
+     */
+    unsigned long alarmTimerAwakeMillis = 0;
+
+    /**
+     * @brief True if the next serviceAlarmTimers() follows an RTC wake (boot, ALM event) and counts as a wake
+     */
+    bool alarmTimerWakePending = false;
+
+    /**
+     * @brief Copy of the timer queue in the RTC RAM
+     */
+    AlarmTimerQueue alarmTimerQueue = {};
+
+    /**
+     * @brief True if FOUT/nIRQ event dispatch is enabled (see withEventInterrupt())
+     */
+    bool eventInterruptEnabled = false;
+
+    /**
+     * @brief Set from the FOUT/nIRQ interrupt service routine, cleared by processEvents()
+     */
+    volatile bool eventPending = false;
+
+    /**
+     * @brief True if startPeriodicTick() is running
+     */
+    bool periodicTickEnabled = false;
+
+    /**
+     * @brief True if startPeriodicTick() is using pulse interrupts
+     */
+    bool periodicTickPulse = false;
+
+    /**
+     * @brief Pulses counted by the FOUT/nIRQ interrupt service routine in pulse mode
+     */
+    volatile uint32_t periodicTickPulses = 0;
+
+    /**
+     * @brief Actual period of the tick in microseconds
+     */
+    uint32_t periodicTickPeriodUs = 0;
+
+    /**
+     * @brief The micros() value when the last tick was detected in level mode
+     */
+    unsigned long periodicTickLastMicros = 0;
+
+    /**
+     * @brief Ticks since startPeriodicTick(), including missed ticks
+     */
+    uint32_t periodicTickCount = 0;
+
+    /**
+     * @brief Missed ticks since startPeriodicTick()
+     */
+    uint32_t periodicTickMissed = 0;
+
+    /**
+     * @brief Function to call for each tick
+     */
+    PeriodicTickHandler periodicTickHandler;
+
+    /**
+     * @brief How often to check REG_STATUS without an interrupt in milliseconds, or 0 to not check
      */
-	virtual bool writeRam(size_t ramAddr, const uint8_t *data, size_t dataLen, bool lock = true);
+    unsigned long eventPollPeriod = 0;
 
     /**
-     * @brief Utility function to convert a struct tm * to a readable string
-     * 
-     * @return String in the format of "yyyy-mm-dd hh:mm:ss". 
+     * @brief The last millis() value when processEvents() was called
      */
-    static String tmToString(const struct tm *timeptr);
+    unsigned long lastEventMillis = 0;
 
     /**
-     * @brief Convert a struct tm to register values for the AB1805
-     * 
-     * @param timeptr Pointer to a struct tm with the values to convert from
-     * 
-     * @param array Array of uint8_t to store the values to. This must be at least 6 bytes
-     * if includeYear is false or 7 if true. This points to the seconds field, not the
-     * hundredths field!
-     * 
-     * @param includeYear True if this is the the year should be included (time setting),
-     * or false if the year should not be included (alarm setting).
-     * 
-     * Note: Does not include the hundredths are struct tm doesn't include fractional seconds.
+     * @brief Event handlers, indexed by REG_STATUS bit number (0 = EX1, 5 = WDT)
      */
-    static void tmToRegisters(const struct tm *timeptr, uint8_t *array, bool includeYear);
+    EventHandler eventHandlers[6];
 
     /**
-     * @brief Convert register values to a struct tm
-     * 
-     * @param array Pointer to an array of values from the AB1805. Point to the seconds
-     * (not hundredths).
-     * 
-     * @param timeptr Pointer to a struct tm to hold the converted time
-     * 
-     * @param includeYear True if this is the the year should be included (time setting),
-     * or false if the year should not be included (alarm setting).
+     * @brief True if the cached RTC clock is enabled (see withCachedClock())
      */
-    static void registersToTm(const uint8_t *array, struct tm *timeptr, bool includeYear);
+    bool cachedClockEnabled = false;
 
     /**
-     * @brief Convert a bcd value (0x00-0x99) into an integer (0-99)
+     * @brief True if cachedClockMs and cachedClockMillis are valid
      */
-    static int bcdToValue(uint8_t bcd);
+    volatile bool cachedClockValid = false;
 
     /**
-     * @brief Convert an integer value (0-99) into a bcd value (0x00 - 0x99)
+     * @brief RTC time in milliseconds since January 1, 1970 UTC when the cached clock was last read
      */
-    static uint8_t valueToBcd(int value);
+    uint64_t cachedClockMs = 0;
 
-    static const uint32_t RESET_PRESERVE_REPEATING_TIMER    = 0x00000001;   //!< When resetting registers, leave repeating timer settings intact
-    static const uint32_t RESET_DISABLE_XT                  = 0x00000002;   //!< When resetting registers, disable XT oscillator
-    
-    static const int WATCHDOG_MAX_SECONDS = 124;    //!< Maximum value that can be passed to setWDT().
+    /**
+     * @brief Value of millis() when the cached clock was last read
+     */
+    unsigned long cachedClockMillis = 0;
 
+    /**
+     * @brief How often to resync the cached clock from loop() in milliseconds
+     */
+    unsigned long cachedClockResyncPeriod = 60000;
 
-    static const uint8_t REG_HUNDREDTH              = 0x00;      //!< Hundredths of a second, 2 BCD digits
-    static const uint8_t REG_SECOND                 = 0x01;      //!< Seconds, 2 BCD digits, MSB is GP0
-    static const uint8_t REG_MINUTE                 = 0x02;      //!< Minutes, 2 BCD digits, MSB is GP1
-    static const uint8_t REG_HOUR                   = 0x03;      //!< Hours, GP2, GP3
-    static const uint8_t REG_DATE                   = 0x04;      //!< Day of month (1-31), 2 BCD digits, GP4, GP5
-    static const uint8_t REG_MONTH                  = 0x05;      //!< Month (1-12), 2 BCD digits, GP6 - GP8
-    static const uint8_t REG_YEAR                   = 0x06;      //!< Year (0-99), 2 BCD digits
-    static const uint8_t REG_WEEKDAY                = 0x07;      //!< Weekday (0-6), GP9 - GP13
-    static const uint8_t REG_HUNDREDTH_ALARM        = 0x08;      //!< Alarm on hundredths of a second (0-99), 2 BCD digits
-    static const uint8_t REG_SECOND_ALARM           = 0x09;      //!< Alarm on seconds (0-59), 2 BCD digits, GP14
-    static const uint8_t REG_MINUTE_ALARM           = 0x0a;      //!< Alarm on minutes (0-59), 2 BCD digits, GP15
-    static const uint8_t REG_HOUR_ALARM             = 0x0b;      //!< Alarm on hour, GP16, GP17
-    static const uint8_t REG_DATE_ALARM             = 0x0c;      //!< Alarm on date (1-31), 2 BCD digits, GP18-GP19
-    static const uint8_t REG_MONTH_ALARM            = 0x0d;      //!< Alarm on month (1-12). 2 BCD digits, GP20-GP22
-    static const uint8_t REG_WEEKDAY_ALARM          = 0x0e;      //!< Alarm on day of week (0-6). GP23-GP27
-    static const uint8_t REG_STATUS                 = 0x0f;      //!< Status register
-    static const uint8_t   REG_STATUS_CB            = 0x80;      //!< Status register century bit mask
-    static const uint8_t   REG_STATUS_BAT           = 0x40;      //!< Status register switched to VBAT bit mask
-    static const uint8_t   REG_STATUS_WDT           = 0x20;      //!< Status register watchdog timer enabled and triggered bit mask
-    static const uint8_t   REG_STATUS_BL            = 0x10;      //!< Status register battery voltage crossing bit mask
-    static const uint8_t   REG_STATUS_TIM           = 0x08;      //!< Status register countdown timer reaches 0 bit mask
-    static const uint8_t   REG_STATUS_ALM           = 0x04;      //!< Status register alarm register match bit mask
-    static const uint8_t   REG_STATUS_EX2           = 0x02;      //!< Status register WDI interrupt bit mask
-    static const uint8_t   REG_STATUS_EX1           = 0x01;      //!< Status register EXTI interrupt bit mask
-    static const uint8_t   REG_STATUS_DEFAULT       = 0x00;      //!< Status register, default
-    static const uint8_t REG_CTRL_1                 = 0x10;      //!< Control register 1
-    static const uint8_t   REG_CTRL_1_STOP          = 0x80;      //!< Control register 1, stop clocking system
-    static const uint8_t   REG_CTRL_1_12_24         = 0x40;      //!< Control register 1, 12/24 hour mode select (0 = 24 hour)
-    static const uint8_t   REG_CTRL_1_OUTB          = 0x20;      //!< Control register 1, value for nIRQ2
-    static const uint8_t   REG_CTRL_1_OUT           = 0x10;      //!< Control register 1, value for FOUT/nIRQ
-    static const uint8_t   REG_CTRL_1_RSP           = 0x08;      //!< Control register 1, Reset polarity
-    static const uint8_t   REG_CTRL_1_ARST          = 0x04;      //!< Control register 1, Auto reset enable
-    static const uint8_t   REG_CTRL_1_PWR2          = 0x02;      //!< Control register 1, PWW/nIRQ pull-down enable
-    static const uint8_t   REG_CTRL_1_WRTC          = 0x01;      //!< Control register 1, write RTC mode
-    static const uint8_t   REG_CTRL_1_DEFAULT       = 0x13;      //!< Control register 1, 0b00010011 (OUT | RSO | PWR2 | WRTC)
-    static const uint8_t REG_CTRL_2                 = 0x11;      //!< Control register 2
-    static const uint8_t   REG_CTRL_2_RS1E          = 0x20;      //!< Control register 2, nIRQ2 output mode
-    static const uint8_t   REG_CTRL_2_OUT2S_MASK    = 0x1c;      //!< Control register 2, nIRQ2 output mode
-    static const uint8_t   REG_CTRL_2_OUT2S_nIRQ    = 0x00;      //!< Control register 2, nIRQ2 output mode, nIRQ or OUTB
-    static const uint8_t   REG_CTRL_2_OUT2S_SQW     = 0x04;      //!< Control register 2, nIRQ2 output mode, SQW or OUTB
-    static const uint8_t   REG_CTRL_2_OUT2S_nAIRQ   = 0x0c;      //!< Control register 2, nIRQ2 output mode, nAIRQ or OUTB
-    static const uint8_t   REG_CTRL_2_OUT2S_TIRQ    = 0x10;      //!< Control register 2, nIRQ2 output mode, TIRQ or OUTB
-    static const uint8_t   REG_CTRL_2_OUT2S_nTIRQ   = 0x14;      //!< Control register 2, nIRQ2 output mode, nTIRQ or OUTB
-    static const uint8_t   REG_CTRL_2_OUT2S_SLEEP   = 0x18;      //!< Control register 2, nIRQ2 output mode, sleep mode
-    static const uint8_t   REG_CTRL_2_OUT2S_OUTB    = 0x1c;      //!< Control register 2, nIRQ2 output mode, OUTB
-    static const uint8_t   REG_CTRL_2_OUT1S_MASK    = 0x03;      //!< Control register 2, FOUT/nIRQ output mode
-    static const uint8_t   REG_CTRL_2_OUT1S_nIRQ    = 0x00;      //!< Control register 2, FOUT/nIRQ output mode, nIRQ, or OUT
-    static const uint8_t   REG_CTRL_2_OUT1S_SQW     = 0x01;      //!< Control register 2, FOUT/nIRQ output mode, SQW or OUT
-    static const uint8_t   REG_CTRL_2_OUT1S_SQW_nIRQ= 0x02;      //!< Control register 2, FOUT/nIRQ output mode, SQW, nIRQ, or OUT
-    static const uint8_t   REG_CTRL_2_OUT1S_nAIRQ   = 0x03;      //!< Control register 2, FOUT/nIRQ output mode, nIRQ or OUT
-    static const uint8_t   REG_CTRL_2_DEFAULT       = 0x3c;      //!< Control register 2, 0b00111100 (OUT2S = OUTB)
-    static const uint8_t REG_INT_MASK               = 0x12;      //!< Interrupt mask
-    static const uint8_t   REG_INT_MASK_CEB         = 0x80;      //!< Interrupt mask, century enable
-    static const uint8_t   REG_INT_MASK_IM          = 0x60;      //!< Interrupt mask, interrupt mode bits (2 bits)
-    static const uint8_t   REG_INT_MASK_BLIE        = 0x10;      //!< Interrupt mask, battery low interrupt enable
-    static const uint8_t   REG_INT_MASK_TIE         = 0x08;      //!< Interrupt mask, timer interrupt enable
-    static const uint8_t   REG_INT_MASK_AIE         = 0x04;      //!< Interrupt mask, alarm interrupt enable
-    static const uint8_t   REG_INT_MASK_EX2E        = 0x02;      //!< Interrupt mask, XT2 interrupt enable
-    static const uint8_t   REG_INT_MASK_EX1E        = 0x01;      //!< Interrupt mask, XT1 interrupt enable
-    static const uint8_t   REG_INT_MASK_DEFAULT     = 0xe0;      //!< Interrupt mask, default 0b11100000 (CEB | IM=1/4 seconds)
-    static const uint8_t REG_SQW                    = 0x13;      //!< Square wave output control
-    static const uint8_t   REG_SQW_SQWE             = 0x80;      //!< Square wave output control, enable
-    static const uint8_t   REG_SQW_DEFAULT          = 0x26;      //!< Square wave output control, default 0b00100110
-    static const uint8_t REG_CAL_XT                 = 0x14;      //!< Calibration for the XT oscillator
-    static const uint8_t REG_CAL_RC_HIGH            = 0x15;      //!< Calibration for the RC oscillator, upper 8 bits
-    static const uint8_t REG_CAL_RC_LOW             = 0x16;      //!< Calibration for the RC oscillator, lower 8 bits
-    static const uint8_t REG_SLEEP_CTRL             = 0x17;      //!< Power control system sleep function
-    static const uint8_t   REG_SLEEP_CTRL_SLP       = 0x80;      //!< Sleep control, enter sleep mode
-    static const uint8_t   REG_SLEEP_CTRL_SLRES     = 0x40;      //!< Sleep control, nRST low on sleep
-    static const uint8_t   REG_SLEEP_CTRL_EX2P      = 0x20;      //!< Sleep control, XT2 on rising WDI
-    static const uint8_t   REG_SLEEP_CTRL_EX1P      = 0x10;      //!< Sleep control, XT1 on rising EXTI
-    static const uint8_t   REG_SLEEP_CTRL_SLST      = 0x08;      //!< Sleep control, set when sleep has occurred
-    static const uint8_t   REG_SLEEP_CTRL_SLTO_MASK = 0x07;      //!< Sleep control, number of 7.8ms periods before sleep
-    static const uint8_t   REG_SLEEP_CTRL_DEFAULT   = 0x00;      //!< Sleep control default (0b00000000)
-    static const uint8_t REG_TIMER_CTRL             = 0x18;      //!< Countdown timer control 
-    static const uint8_t   REG_TIMER_CTRL_TE        = 0x80;      //!< Countdown timer control, timer enable 
-    static const uint8_t   REG_TIMER_CTRL_TM        = 0x40;      //!< Countdown timer control, timer interrupt mode
-    static const uint8_t   REG_TIMER_CTRL_TRPT      = 0x20;      //!< Countdown timer control, timer repeat function
-    static const uint8_t   REG_TIMER_CTRL_RPT_MASK  = 0x1c;      //!< Countdown timer control, repeat function
-    static const uint8_t   REG_TIMER_CTRL_RPT_HUN   = 0x1c;      //!< Countdown timer control, repeat hundredths match (7)
-    static const uint8_t   REG_TIMER_CTRL_RPT_SEC   = 0x18;      //!< Countdown timer control, repeat hundredths, seconds match (once per minute) (6)
-    static const uint8_t   REG_TIMER_CTRL_RPT_MIN   = 0x14;      //!< Countdown timer control, repeat hundredths, seconds, minutes match (once per hour) (5)
-    static const uint8_t   REG_TIMER_CTRL_RPT_HOUR  = 0x10;      //!< Countdown timer control, repeat hundredths, seconds, minutes, hours match (once per day) (4)
-    static const uint8_t   REG_TIMER_CTRL_RPT_WKDY  = 0x0c;      //!< Countdown timer control, repeat hundredths, seconds, minutes, hours, weekday match (once per week) (3)
-    static const uint8_t   REG_TIMER_CTRL_RPT_DATE  = 0x08;      //!< Countdown timer control, repeat hundredths, seconds, minutes, hours, date match (once per month) (2)
-    static const uint8_t   REG_TIMER_CTRL_RPT_MON   = 0x04;      //!< Countdown timer control, repeat hundredths, seconds, minutes, hours, date, month match (once per year) (1)
-    static const uint8_t   REG_TIMER_CTRL_RPT_DIS   = 0x00;      //!< Countdown timer control, alarm disabled (0)
-    static const uint8_t   REG_TIMER_CTRL_TFS_MASK  = 0x03;      //!< Countdown timer control, clock frequency
-    static const uint8_t   REG_TIMER_CTRL_TFS_FAST  = 0x00;      //!< Countdown timer control, clock frequency 4.096 kHz or 128 Hz
-    static const uint8_t   REG_TIMER_CTRL_TFS_64    = 0x01;      //!< Countdown timer control, clock frequency 64 Hz
-    static const uint8_t   REG_TIMER_CTRL_TFS_1     = 0x02;      //!< Countdown timer control, clock frequency 1 Hz
-    static const uint8_t   REG_TIMER_CTRL_TFS_1_60  = 0x03;      //!< Countdown timer control, clock frequency 1/60 Hz (1 minute)
-    static const uint8_t   REG_TIMER_CTRL_DEFAULT   = 0x23;      //!< Countdown timer control, 0b00100011 (TFPT + TFS = 1/60 Hz0)
-    static const uint8_t REG_TIMER                  = 0x19;      //!< Countdown timer current value register
-    static const uint8_t   REG_TIMER_DEFAULT        = 0x00;      //!< Countdown timer current value register default value (0x00)
-    static const uint8_t REG_TIMER_INITIAL          = 0x1a;      //!< Countdown timer inital (reload) value register
-    static const uint8_t   REG_TIMER_INITIAL_DEFAULT= 0x00;      //!< Countdown timer inital value register default value 
-    static const uint8_t REG_WDT                    = 0x1b;      //!< Watchdog timer control register
-    static const uint8_t   REG_WDT_RESET            = 0x80;      //!< Watchdog timer control, enable reset (1) or WIRQ (0)
-    static const uint8_t   REG_WDT_WRB_16_HZ        = 0x00;      //!< Watchdog timer control, WRB watchdog clock = 16 Hz
-    static const uint8_t   REG_WDT_WRB_4_HZ         = 0x01;      //!< Watchdog timer control, WRB watchdog clock = 4 Hz
-    static const uint8_t   REG_WDT_WRB_1_HZ         = 0x02;      //!< Watchdog timer control, WRB watchdog clock = 1 Hz
-    static const uint8_t   REG_WDT_WRB_1_4_HZ       = 0x03;      //!< Watchdog timer control, WRB watchdog clock = 1/4 Hz
-    static const uint8_t   REG_WDT_DEFAULT          = 0x00;      //!< Watchdog timer control, default value
-    static const uint8_t REG_OSC_CTRL               = 0x1c;      //!< Oscillator control register
-    static const uint8_t   REG_OSC_CTRL_OSEL        = 0x80;      //!< Oscillator control, clock select 32.768 kHz (0) or 128 Hz (1)
-    static const uint8_t   REG_OSC_CTRL_ACAL        = 0x60;      //!< Oscillator control, auto-calibration
-    static const uint8_t   REG_OSC_CTRL_AOS         = 0x10;      //!< Oscillator control, automatic switch to RC oscillator on battery
-    static const uint8_t   REG_OSC_CTRL_FOS         = 0x08;      //!< Oscillator control, automatic switch to RC oscillator on failure
-    static const uint8_t   REG_OSC_CTRL_PWGT        = 0x04;      //!< Oscillator control, IO interface disable
-    static const uint8_t   REG_OSC_CTRL_OFIE        = 0x02;      //!< Oscillator control, oscillator fail interrupt enable
-    static const uint8_t   REG_OSC_CTRL_ACIE        = 0x01;      //!< Oscillator control, auto-calibration fail interrupt enable
-    static const uint8_t   REG_OSC_CTRL_DEFAULT     = 0x00;      //!< Oscillator control, default value
-    static const uint8_t REG_OSC_STATUS             = 0x1d;      //!< Oscillator status register
-    static const uint8_t   REG_OSC_STATUS_XTCAL     = 0x0c;      //!< Oscillator status register, extended crystal calibration
-    static const uint8_t   REG_OSC_STATUS_LKO2      = 0x04;      //!< Oscillator status register, lock OUT2
-    static const uint8_t   REG_OSC_STATUS_OMODE     = 0x01;      //!< Oscillator status register, oscillator mode (read-only)
-    static const uint8_t   REG_OSC_STATUS_OF        = 0x02;      //!< Oscillator status register, oscillator failure
-    static const uint8_t   REG_OSC_STATUS_ACF       = 0x01;      //!< Oscillator status register, auto-calibration failure
-    static const uint8_t REG_CONFIG_KEY             = 0x1f;      //!< Register to set to modify certain other keys
-    static const uint8_t   REG_CONFIG_KEY_OSC_CTRL  = 0xa1;      //!< Configuration key, enable setting REG_OSC_CTRL
-    static const uint8_t   REG_CONFIG_KEY_SW_RESET  = 0x3c;      //!< Configuration key, software reset
-    static const uint8_t   REG_CONFIG_KEY_OTHER     = 0x9d;      //!< Configuration key, REG_TRICKLE, REG_BREF_CTRL, REG_AFCTRL, REG_BATMODE_IO, REG_OCTRL
-    static const uint8_t REG_TRICKLE                = 0x20;      //!< Trickle charger control register
-    static const uint8_t   REG_TRICKLE_DEFAULT      = 0x00;      //!< Trickle charger control register, default value
-    static const uint8_t   REG_TRICKLE_TCS_MASK     = 0xf0;      //!< Trickle charger control register, enable mask
-    static const uint8_t   REG_TRICKLE_TCS_ENABLE   = 0xa0;      //!< Trickle charger control register, enable value (0b10100000)
-    static const uint8_t   REG_TRICKLE_DIODE_MASK   = 0x0c;      //!< Trickle charger control register, diode mask
-    static const uint8_t   REG_TRICKLE_DIODE_0_6    = 0x08;      //!< Trickle charger control register, diode 0.6V drop
-    static const uint8_t   REG_TRICKLE_DIODE_0_3    = 0x04;      //!< Trickle charger control register, diode 0.3V drop
-    static const uint8_t   REG_TRICKLE_ROUT_MASK    = 0x03;      //!< Trickle charger control register, rout mask
-    static const uint8_t   REG_TRICKLE_ROUT_11K     = 0x03;      //!< Trickle charger control register, rout 11K
-    static const uint8_t   REG_TRICKLE_ROUT_6K      = 0x02;      //!< Trickle charger control register, rout 6K
-    static const uint8_t   REG_TRICKLE_ROUT_3K      = 0x01;      //!< Trickle charger control register, rout 3K
-    static const uint8_t   REG_TRICKLE_ROUT_DISABLE = 0x00;      //!< Trickle charger control register, rout disable
-    static const uint8_t REG_BREF_CTRL              = 0x21;      //!< Wakeup control system reference voltages
-    static const uint8_t   REG_BREF_CTRL_DEFAULT    = 0xf0;      //!< Wakeup control system default 0b11110000
-    static const uint8_t   REG_BREF_CTRL_25_30      = 0x70;      //!< Wakeup control falling 2.5V rising 3.0V
-    static const uint8_t   REG_BREF_CTRL_21_25      = 0xb0;      //!< Wakeup control falling 2.1V rising 2.5V
-    static const uint8_t   REG_BREF_CTRL_18_22      = 0xd0;      //!< Wakeup control falling 1.8V rising 2.2V
-    static const uint8_t   REG_BREF_CTRL_14_16      = 0xf0;      //!< Wakeup control falling 1.4V rising 1.6V, default value
-    static const uint8_t REG_AFCTRL                 = 0x26;      //!< Auto-calibration filter capacitor enable register
-    static const uint8_t   REG_AFCTRL_ENABLE        = 0xa0;      //!< Auto-calibration filter capacitor enable
-    static const uint8_t   REG_AFCTRL_DISABLE       = 0x00;      //!< Auto-calibration filter capacitor disable
-    static const uint8_t   REG_AFCTRL_DEFAULT       = 0x00;      //!< Auto-calibration filter, default
-    static const uint8_t REG_BATMODE_IO             = 0x27;      //!< Brownout control for IO interface
-    static const uint8_t   REG_BATMODE_IO_DEFAULT   = 0x80;      //!< Brownout control for IO interface, default value
-    static const uint8_t   REG_BATMODE_IO_IOBM      = 0x80;      //!< Brownout control for IO interface, enable IO when on VBAT
-    static const uint8_t REG_ID0                    = 0x28;      //!< Part number, upper (read-only)
-    static const uint8_t   REG_ID0_AB08XX           = 0x18;      //!< Part number, upper, AB08xx
-    static const uint8_t   REG_ID0_AB18XX           = 0x18;      //!< Part number, upper, AB18xx
-    static const uint8_t REG_ID1                    = 0x29;      //!< Part number, lower (read-only)
-    static const uint8_t   REG_ID1_ABXX05           = 0x05;      //!< Part number, lower, AB1805 or AB0805 (I2C)
-    static const uint8_t   REG_ID1_ABXX15           = 0x05;      //!< Part number, lower, AB1815 or AB0815 (SPI)
-    static const uint8_t REG_ID2                    = 0x2a;      //!< Part revision (read-only)
-    static const uint8_t REG_ID3                    = 0x2b;      //!< Lot number, lower (read-only)
-    static const uint8_t REG_ID4                    = 0x2c;      //!< Manufacturing unique ID upper (read-only)
-    static const uint8_t REG_ID5                    = 0x2d;      //!< Manufacturing unique ID lower (read-only)
-    static const uint8_t REG_ID6                    = 0x2e;      //!< Lot and wafer information (read-only)
-    static const uint8_t REG_ASTAT                  = 0x2f;      //!< Analog status register (read-only)
-    static const uint8_t   REG_ASTAT_BBOD           = 0x80;      //!< Analog status register. VBAT is above BREF (read-only)
-    static const uint8_t   REG_ASTAT_BMIN           = 0x40;      //!< Analog status register. VBAT is above minimum operating voltage 1.2V (read-only)
-    static const uint8_t   REG_ASTAT_VINIT          = 0x02;      //!< Analog status register. VCC is about minimum 1.6V (read-only)
-    static const uint8_t REG_OCTRL                  = 0x30;      //!< Output control register at power-down
-    static const uint8_t   REG_OCTRL_WDBM           = 0x80;      //!< Output control register, WDI enabled when powered from VBAT
-    static const uint8_t   REG_OCTRL_EXBM           = 0x40;      //!< Output control register, EXTI enabled when powered from VBAT
-    static const uint8_t   REG_OCTRL_WDDS           = 0x20;      //!< Output control register, WDI disabled in sleep 
-    static const uint8_t   REG_OCTRL_EXDS           = 0x10;      //!< Output control register, EXTI disabled in sleep
-    static const uint8_t   REG_OCTRL_RSEN           = 0x08;      //!< Output control register, nRST output enabled in sleep
-    static const uint8_t   REG_OCTRL_O4EN           = 0x04;      //!< Output control register, CLKOUT/nIRQ3 enabled in sleep
-    static const uint8_t   REG_OCTRL_O3EN           = 0x02;      //!< Output control register, nTIRQ enabled in sleep
-    static const uint8_t   REG_OCTRL_O1EN           = 0x01;      //!< Output control register, FOUT/nIRQ enabled in sleep 
-    static const uint8_t   REG_OCTRL_DEFAULT        = 0x00;      //!< Output control register, default 
-    static const uint8_t REG_EXT_ADDR               = 0x3f;      //!< Extension RAM address
-    static const uint8_t   REG_EXT_ADDR_O4MB        = 0x80;      //!< Extension RAM address, CLKOUT/nIRQ3 enabled when powered from VBAT
-    static const uint8_t   REG_EXT_ADDR_BPOL        = 0x40;      //!< Extension RAM address, BL polarity
-    static const uint8_t   REG_EXT_ADDR_WDIN        = 0x20;      //!< Extension RAM address, level of WDI pin (read-only)
-    static const uint8_t   REG_EXT_ADDR_EXIN        = 0x10;      //!< Extension RAM address, level of EXTI pin (read-only)
-    static const uint8_t   REG_EXT_ADDR_XADA        = 0x04;      //!< Extension RAM address, Upper bit of alternate RAM address
-    static const uint8_t   REG_EXT_ADDR_XADS        = 0x03;      //!< Extension RAM address, Upper 2 bits of standard RAM address
-    static const uint8_t REG_RAM                    = 0x40;      //!< Standard RAM
-    static const uint8_t REG_ALT_RAM                = 0x80;      //!< Alternate RAM address
+    /**
+     * @brief Maximum estimated error before the cached clock is resynced from loop() in milliseconds
+     */
+    unsigned long cachedClockMaxError = 50;
 
+    /**
+     * @brief Accuracy of the MCU millis() clock in parts per million
+     */
+    uint32_t cachedClockPpm = 250;
 
-protected:
     /**
-     * @brief Internal function used to handle system events
-     * 
-     * We currently only handle the reset event to disable the WDT before reset so it
-     * won't trigger during a OTA firmware update.
+     * @brief True if XT oscillator calibration is enabled (see withCalibration())
      */
-    void systemEvent(system_event_t event, int param);
+    bool calibrationEnabled = false;
 
     /**
-     * @brief Static function passed to System.on
-     * 
-     * AB1805 is a singleton so AB1805::instance is used to find the instance pointer.
+     * @brief Address in the RTC RAM of the CalibrationState
      */
-    static void systemEventStatic(system_event_t event, int param);
+    size_t calibrationRamAddr = 0;
 
     /**
-     * @brief Which I2C (TwoWire) interface to use. Usually Wire, is Wire1 on Tracker SoM
+     * @brief Minimum span of the samples in seconds before the calibration is changed
      */
-    TwoWire &wire = Wire; 
+    uint32_t calibrationMinSpan = 172800;
 
     /**
-     * @brief I2C address, always 0x69 as that is the address hardwired in the AB1805
+     * @brief Minimum measured drift in ppm before the calibration is changed
      */
-    uint8_t i2cAddr = 0x69;
+    float calibrationMinErrorPpm = 2.0;
 
     /**
-     * @brief Which GPIO is connected to FOUT/nIRQ
-     * 
-     * Set to PIN_INVALID if not connected. 
-     * 
-     * This is used for interrupts, and also to detect if the AB1805 is alive, during
-     * detectChip(). If not connected, then only I2C is used to detect the chip.
+     * @brief The value returned by Particle.timeSyncedLast() when the last sample was taken
      */
-    pin_t foutPin = PIN_INVALID;
+    unsigned long calibrationSyncMillis = 0;
 
     /**
-     * @brief Watchdog period in seconds (1 <= watchdogSecs <= 124) or 0 for disabled.
-     * 
-     * This is used so setWDT(-1) can restore the previous value.
+     * @brief Copy of the calibration state in the RTC RAM
      */
-    int watchdogSecs = 0;
+    CalibrationState calibrationState = {};
 
     /**
-     * @brief The last millis() value where we called setWDT(-1)
+     * @brief True if the shadow register cache is enabled (see withRegisterCache())
      */
-    unsigned long lastWatchdogMillis = 0;
+    bool registerCacheEnabled = false;
 
     /**
-     * @brief How often to call updateWDT(-1) in milliseconds
+     * @brief Bit mask of valid entries in registerCache, bit 0 = REG_CACHE_FIRST
      */
-    unsigned long watchdogUpdatePeriod = 0;
+    uint64_t registerCacheValid = 0;
 
     /**
-     * @brief True if we've set the RTC from the cloud time
+     * @brief Shadow copy of registers REG_CACHE_FIRST to REG_CACHE_LAST
      */
-    bool timeSet = false;
+    uint8_t registerCache[REG_CACHE_SIZE];
 
     /**
-     * @brief The reason for wake. Set during setup()
+     * @brief The value written to REG_CONFIG_KEY by the most recent write transaction, or 0
+     *
+     * The key only applies to the write that immediately follows it.
      */
-    WakeReason wakeReason = WakeReason::UNKNOWN;
+    uint8_t lastConfigKey = 0;
 
     /**
      * @brief Singleton for AB1805. Set in constructor